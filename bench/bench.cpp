@@ -0,0 +1,232 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "corpus.h"
+
+namespace
+{
+    using jco::serialization::Style;
+
+    const std::size_t   corpus_bytes    = 1 << 20;
+    const std::uint64_t corpus_seed     = 239;
+
+    const char * style_name(Style style)
+    {
+        return (style == Style::SingleLine) ? "single_line" : "pretty";
+    }
+
+    std::size_t skip_document(std::string const & json)
+    {
+        jco::details::ParserState st{ jco::from_string(json), 0 };
+        jco::details::skip_value(st);
+        return st.ptr;
+    }
+
+    template<class Doc>
+    void register_shape(const char * shape, Doc const & doc, std::function<std::size_t (std::string const &)> parse)
+    {
+        for (Style style : { Style::SingleLine, Style::Pretty })
+        {
+            std::string json = corpus::to_json(doc, style);
+            std::string suffix = std::string(shape) + "/" + style_name(style);
+
+            benchmark::RegisterBenchmark(("parse/" + suffix).c_str(), [json, parse] (benchmark::State & state) {
+                for (auto _ : state)
+                    benchmark::DoNotOptimize(parse(json));
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+
+            benchmark::RegisterBenchmark(("skip/" + suffix).c_str(), [json] (benchmark::State & state) {
+                for (auto _ : state)
+                    benchmark::DoNotOptimize(skip_document(json));
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+
+            benchmark::RegisterBenchmark(("validate/" + suffix).c_str(), [json] (benchmark::State & state) {
+                for (auto _ : state)
+                    benchmark::DoNotOptimize(jco::validate(jco::from_string(json)));
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+
+            benchmark::RegisterBenchmark(("serialize/" + suffix).c_str(), [&doc, style, json] (benchmark::State & state) {
+                for (auto _ : state)
+                    benchmark::DoNotOptimize(corpus::to_json(doc, style));
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+        }
+    }
+
+    template<class Doc>
+    std::size_t parse_records(std::string const & json)
+    {
+        return jco::parse<Doc>(jco::from_string(json)).records.size();
+    }
+
+    // documents written by jco itself, parsed with ParseOptions::trusted
+    template<class Doc>
+    void register_trusted(const char * shape, Doc const & doc)
+    {
+        std::string json = corpus::to_json(doc, Style::SingleLine);
+        std::string name = std::string("parse_trusted/") + shape + "/" + style_name(Style::SingleLine);
+
+        benchmark::RegisterBenchmark(name.c_str(), [json] (benchmark::State & state) {
+            jco::ParseOptions options;
+            options.trusted = true;
+            for (auto _ : state)
+                benchmark::DoNotOptimize(jco::parse<Doc>(jco::from_string(json), options).records.size());
+            state.SetBytesProcessed(state.iterations() * json.size());
+        });
+    }
+
+    // Documents have to outlive benchmark registration.
+    corpus::Numbers         numbers;
+    corpus::Strings         strings;
+    corpus::Nested          nested;
+    corpus::Wide            wide;
+    corpus::Heterogeneous   heterogeneous;
+
+    void register_all()
+    {
+        corpus::Random rnd(corpus_seed);
+
+        numbers         = corpus::make_numbers(rnd, corpus_bytes);
+        strings         = corpus::make_strings(rnd, corpus_bytes);
+        nested          = corpus::make_nested(rnd, corpus_bytes);
+        wide            = corpus::make_wide(rnd, corpus_bytes);
+        heterogeneous   = corpus::make_heterogeneous(rnd, corpus_bytes);
+
+        register_shape("numbers",   numbers,    &parse_records<corpus::Numbers>);
+        register_shape("strings",   strings,    &parse_records<corpus::Strings>);
+        register_shape("nested",    nested,     &parse_records<corpus::Nested>);
+        register_shape("wide",      wide,       &parse_records<corpus::Wide>);
+
+        register_trusted("numbers", numbers);
+        register_trusted("strings", strings);
+        register_trusted("nested",  nested);
+        register_trusted("wide",    wide);
+
+        // factories are registered once, only parsing is timed
+        auto parser = std::make_shared<jco::TypedParser<corpus::Element>>();
+        corpus::register_factories(*parser);
+
+        register_shape("heterogeneous", heterogeneous, [parser] (std::string const & json) {
+            std::size_t weight = 0;
+            parser->parse_array(jco::from_string(json), [&weight] (corpus::ElementPtr e) {
+                weight += e->weight();
+            });
+            return weight;
+        });
+
+        for (Style style : { Style::SingleLine, Style::Pretty })
+        {
+            auto json = corpus::to_json(heterogeneous, style);
+            auto name = std::string("parse_variant/heterogeneous/") + style_name(style);
+
+            benchmark::RegisterBenchmark(name.c_str(), [json] (benchmark::State & state) {
+                std::vector<corpus::ElementValue> elements;
+                for (auto _ : state)
+                {
+                    jco::parse_into(jco::from_string(json), elements);
+                    benchmark::DoNotOptimize(elements.data());
+                }
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+        }
+
+        for (Style style : { Style::SingleLine, Style::Pretty })
+        {
+            auto json = corpus::to_json(heterogeneous, style);
+            auto name = std::string("parse_pooled/heterogeneous/") + style_name(style);
+
+            benchmark::RegisterBenchmark(name.c_str(), [json] (benchmark::State & state) {
+                jco::TypedParser<corpus::Element> parser;
+                corpus::register_factories(parser);
+
+                // slots released by one iteration are reused by the next one
+                jco::ParseContext ctx;
+                std::vector<jco::pooled_ptr<corpus::Element>> elements;
+                for (auto _ : state)
+                {
+                    elements.clear();
+                    parser.parse_array(jco::from_string(json), ctx, [&elements] (jco::pooled_ptr<corpus::Element> e) {
+                        elements.push_back(std::move(e));
+                    });
+                    benchmark::DoNotOptimize(elements.data());
+                }
+                elements.clear();
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+        }
+
+        for (Style style : { Style::SingleLine, Style::Pretty })
+        {
+            auto json = corpus::to_json(heterogeneous, style);
+            auto name = std::string("forward_lazy/heterogeneous/") + style_name(style);
+
+            // routing: elements are written out again by their types, descriptions untouched
+            benchmark::RegisterBenchmark(name.c_str(), [json, style] (benchmark::State & state) {
+                jco::TypedParser<corpus::Element> parser;
+                corpus::register_factories(parser);
+
+                for (auto _ : state)
+                {
+                    std::ostringstream ss;
+                    {
+                        jco::serialization::out_stream out(ss, style);
+                        jco::serialization::array_scope as(out);
+                        parser.parse_lazy_array(jco::from_string(json), [&out] (jco::lazy_object<corpus::Element> e) {
+                            jco::serialization::write(out, e);
+                        });
+                    }
+                    benchmark::DoNotOptimize(ss.str());
+                }
+                state.SetBytesProcessed(state.iterations() * json.size());
+            });
+        }
+
+        for (Style style : { Style::SingleLine, Style::Pretty })
+        {
+            auto size = corpus::to_json(heterogeneous, style).size();
+            auto name = std::string("serialize_parallel/heterogeneous/") + style_name(style);
+
+            benchmark::RegisterBenchmark(name.c_str(), [style, size] (benchmark::State & state) {
+                for (auto _ : state)
+                {
+                    std::ostringstream ss;
+                    {
+                        jco::serialization::out_stream out(ss, style);
+                        out << jco::serialization::parallel(heterogeneous);
+                    }
+                    benchmark::DoNotOptimize(ss.str());
+                }
+                state.SetBytesProcessed(state.iterations() * size);
+            });
+        }
+    }
+}
+
+// Same as BENCHMARK_MAIN(), but reports JSON unless another format is requested,
+// so results can be stored and compared between versions as is.
+int main(int argc, char ** argv)
+{
+    std::vector<char *> args(argv, argv + argc);
+
+    char json_format[] = "--benchmark_format=json";
+    bool has_format = false;
+    for (int i = 1; i != argc; ++i)
+        has_format |= (std::strncmp(argv[i], "--benchmark_format", 18) == 0);
+    if (!has_format)
+        args.push_back(json_format);
+
+    int args_num = static_cast<int>(args.size());
+    benchmark::Initialize(&args_num, args.data());
+    if (benchmark::ReportUnrecognizedArguments(args_num, args.data()))
+        return 1;
+
+    register_all();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
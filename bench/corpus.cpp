@@ -0,0 +1,329 @@
+#include "corpus.h"
+
+namespace corpus
+{
+    std::uint64_t Random::next()
+    {
+        std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    std::size_t Random::uniform(std::size_t bound)
+    {
+        return static_cast<std::size_t>(next() % bound);
+    }
+
+    double Random::real(double lo, double hi)
+    {
+        // 53 random bits -> [0, 1)
+        double unit = (next() >> 11) * (1.0 / 9007199254740992.0);
+        return lo + (hi - lo) * unit;
+    }
+
+    bool Random::chance(unsigned percent)
+    {
+        return uniform(100) < percent;
+    }
+
+    namespace
+    {
+        const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+        const char escaped[]  = "\"\\\n\t/";
+
+        std::string make_word(Random & rnd, std::size_t min_len, std::size_t max_len, unsigned escape_percent = 0)
+        {
+            std::string res(min_len + rnd.uniform(max_len - min_len + 1), ' ');
+            for (char & c : res)
+            {
+                if (escape_percent && rnd.chance(escape_percent))
+                    c = escaped[rnd.uniform(sizeof(escaped) - 1)];
+                else
+                    c = alphabet[rnd.uniform(sizeof(alphabet) - 1)];
+            }
+            return res;
+        }
+
+        double make_number(Random & rnd)
+        {
+            switch (rnd.uniform(3))
+            {
+            case 0:
+                return static_cast<double>(rnd.uniform(100000));
+            case 1:
+                return rnd.real(-180, 180);
+            default:
+                return rnd.real(-1e12, 1e12);
+            }
+        }
+
+        std::vector<std::vector<double>> make_matrix(Random & rnd)
+        {
+            std::vector<std::vector<double>> res(2);
+            for (auto & row : res)
+                for (std::size_t i = 0; i != 3; ++i)
+                    row.push_back(make_number(rnd));
+            return res;
+        }
+
+        // Serializes every generated record on its own to find out how many
+        // records are needed to reach the requested (single line) size.
+        template<class Record, class Doc>
+        void fill(Doc & doc, std::size_t approx_bytes, Random & rnd, Record (*make)(Random &))
+        {
+            std::size_t size = 0;
+            while (size < approx_bytes)
+            {
+                doc.records.push_back(make(rnd));
+                Doc single;
+                single.records.push_back(doc.records.back());
+                size += to_json(single, jco::serialization::Style::SingleLine).size();
+            }
+        }
+
+        NumberRecord make_number_record(Random & rnd)
+        {
+            NumberRecord res;
+            res.x = make_number(rnd);
+            res.y = make_number(rnd);
+            res.z = make_number(rnd);
+            res.timestamp = 1400000000 + static_cast<double>(rnd.uniform(100000000));
+            res.samples.resize(8 + rnd.uniform(24));
+            for (double & s : res.samples)
+                s = make_number(rnd);
+            return res;
+        }
+
+        StringRecord make_string_record(Random & rnd)
+        {
+            StringRecord res;
+            res.id = make_word(rnd, 16, 16);
+            res.name = make_word(rnd, 4, 24);
+            res.text = make_word(rnd, 64, 512, 2);
+            res.tags.resize(rnd.uniform(6));
+            for (auto & tag : res.tags)
+                tag = make_word(rnd, 3, 12);
+            return res;
+        }
+
+        Leaf make_leaf(Random & rnd)
+        {
+            Leaf res;
+            res.value = make_number(rnd);
+            res.label = make_word(rnd, 4, 16);
+            return res;
+        }
+
+        template<class Level, class Inner>
+        Level make_level(Random & rnd, double depth, Inner inner)
+        {
+            Level res;
+            res.depth = depth;
+            res.m = make_matrix(rnd);
+            res.child = std::move(inner);
+            return res;
+        }
+
+        Level8 make_level8(Random & rnd)
+        {
+            auto l1 = make_level<Level1>(rnd, 1, make_leaf(rnd));
+            auto l2 = make_level<Level2>(rnd, 2, std::move(l1));
+            auto l3 = make_level<Level3>(rnd, 3, std::move(l2));
+            auto l4 = make_level<Level4>(rnd, 4, std::move(l3));
+            auto l5 = make_level<Level5>(rnd, 5, std::move(l4));
+            auto l6 = make_level<Level6>(rnd, 6, std::move(l5));
+            auto l7 = make_level<Level7>(rnd, 7, std::move(l6));
+            return make_level<Level8>(rnd, 8, std::move(l7));
+        }
+
+        struct wide_filler
+        {
+            Random & rnd;
+
+            void operator() (double & x, const char *)      { x = make_number(rnd); }
+            void operator() (std::string & s, const char *) { s = make_word(rnd, 8, 32); }
+        };
+
+        WideRecord make_wide_record(Random & rnd)
+        {
+            WideRecord res;
+            for_each(res, wide_filler{ rnd });
+            return res;
+        }
+    }
+
+    namespace point_details
+    {
+        DEF_OBJECT(jco_repr,
+            DEF_FIELD(double, x)
+            DEF_FIELD(double, y)
+            DEF_FIELD(std::string, name)
+        )
+    }
+
+    ElementPtr Point::from_jco(jco::Parser & parser)
+    {
+        auto jr = parser.parse<point_details::jco_repr>();
+        std::unique_ptr<Point> res(new Point);
+        res->x = jr.x;
+        res->y = jr.y;
+        res->name = std::move(jr.name);
+        return res;
+    }
+
+    jco::pooled_ptr<Element> Point::from_jco_pooled(jco::Parser & parser, jco::ParseContext & ctx)
+    {
+        auto jr = parser.parse<point_details::jco_repr>();
+        auto res = ctx.make<Point>();
+        res->x = jr.x;
+        res->y = jr.y;
+        res->name = std::move(jr.name);
+        return res;
+    }
+
+    void Point::serialize(jco::serialization::out_stream & out) const
+    {
+        using namespace jco::serialization;
+
+        object_scope os(out);
+        out << key("type") << value(JCO_CLASS_NAME)
+            << key("description") << value(object);
+
+        object_scope ds(out);
+        out << key("x")     << value(x)
+            << key("y")     << value(y)
+            << key("name")  << value(name);
+    }
+
+    namespace label_details
+    {
+        DEF_OBJECT(jco_repr,
+            DEF_FIELD(std::string, a)
+            DEF_FIELD(double, b)
+        )
+    }
+
+    ElementPtr Label::from_jco(jco::Parser & parser)
+    {
+        auto jr = parser.parse<label_details::jco_repr>();
+        std::unique_ptr<Label> res(new Label);
+        res->a = std::move(jr.a);
+        res->b = jr.b;
+        return res;
+    }
+
+    jco::pooled_ptr<Element> Label::from_jco_pooled(jco::Parser & parser, jco::ParseContext & ctx)
+    {
+        auto jr = parser.parse<label_details::jco_repr>();
+        auto res = ctx.make<Label>();
+        res->a = std::move(jr.a);
+        res->b = jr.b;
+        return res;
+    }
+
+    void Label::serialize(jco::serialization::out_stream & out) const
+    {
+        using namespace jco::serialization;
+
+        object_scope os(out);
+        out << key("type") << value(JCO_CLASS_NAME)
+            << key("description") << value(object);
+
+        object_scope ds(out);
+        out << key("a") << value(a)
+            << key("b") << value(b);
+    }
+
+    void register_factories(jco::TypedParser<Element> & parser)
+    {
+        parser.register_factory(Point::JCO_CLASS_NAME, &Point::from_jco);
+        parser.register_factory(Label::JCO_CLASS_NAME, &Label::from_jco);
+        parser.register_pooled_factory(Point::JCO_CLASS_NAME, &Point::from_jco_pooled);
+        parser.register_pooled_factory(Label::JCO_CLASS_NAME, &Label::from_jco_pooled);
+    }
+
+    Numbers make_numbers(Random & rnd, std::size_t approx_bytes)
+    {
+        Numbers res;
+        fill(res, approx_bytes, rnd, &make_number_record);
+        return res;
+    }
+
+    Strings make_strings(Random & rnd, std::size_t approx_bytes)
+    {
+        Strings res;
+        fill(res, approx_bytes, rnd, &make_string_record);
+        return res;
+    }
+
+    Nested make_nested(Random & rnd, std::size_t approx_bytes)
+    {
+        Nested res;
+        fill(res, approx_bytes, rnd, &make_level8);
+        return res;
+    }
+
+    Wide make_wide(Random & rnd, std::size_t approx_bytes)
+    {
+        Wide res;
+        fill(res, approx_bytes, rnd, &make_wide_record);
+        return res;
+    }
+
+    Heterogeneous make_heterogeneous(Random & rnd, std::size_t approx_bytes)
+    {
+        Heterogeneous res;
+        std::size_t size = 0;
+        while (size < approx_bytes)
+        {
+            if (rnd.chance(50))
+            {
+                std::unique_ptr<Point> pt(new Point);
+                pt->x = make_number(rnd);
+                pt->y = make_number(rnd);
+                pt->name = make_word(rnd, 4, 32);
+                res.push_back(std::move(pt));
+            }
+            else
+            {
+                std::unique_ptr<Label> label(new Label);
+                label->a = make_word(rnd, 4, 64, 1);
+                label->b = make_number(rnd);
+                res.push_back(std::move(label));
+            }
+            std::ostringstream ss;
+            {
+                jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+                res.back()->serialize(out);
+            }
+            size += ss.str().size();
+        }
+        return res;
+    }
+
+    void write(jco::serialization::out_stream & out, Numbers const & doc)
+    {
+        jco::serialization::write(out, doc);
+    }
+
+    void write(jco::serialization::out_stream & out, Strings const & doc)
+    {
+        jco::serialization::write(out, doc);
+    }
+
+    void write(jco::serialization::out_stream & out, Nested const & doc)
+    {
+        jco::serialization::write(out, doc);
+    }
+
+    void write(jco::serialization::out_stream & out, Wide const & doc)
+    {
+        jco::serialization::write(out, doc);
+    }
+
+    void write(jco::serialization::out_stream & out, Heterogeneous const & doc)
+    {
+        out << doc;
+    }
+}
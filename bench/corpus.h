@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "jco/jco.h"
+
+namespace corpus
+{
+    // splitmix64: tiny, fast and -- unlike std::*_distribution -- gives the
+    // same sequence with every standard library, so the corpus is byte-identical
+    // across machines and compilers.
+    struct Random
+    {
+        explicit Random(std::uint64_t seed)
+            : state_(seed)
+        {}
+
+        std::uint64_t next();
+
+        std::size_t uniform(std::size_t bound);
+        double      real(double lo, double hi);
+        bool        chance(unsigned percent);
+
+    private:
+        std::uint64_t state_;
+    };
+
+    DEF_OBJECT(NumberRecord,
+        DEF_FIELD(double, x)
+        DEF_FIELD(double, y)
+        DEF_FIELD(double, z)
+        DEF_FIELD(double, timestamp, "ts")
+        DEF_FIELD(std::vector<double>, samples)
+    )
+
+    DEF_OBJECT(Numbers,
+        DEF_FIELD(std::vector<NumberRecord>, records)
+    )
+
+    DEF_OBJECT(StringRecord,
+        DEF_FIELD(std::string, id)
+        DEF_FIELD(std::string, name)
+        DEF_FIELD(std::string, text)
+        DEF_FIELD(std::vector<std::string>, tags)
+    )
+
+    DEF_OBJECT(Strings,
+        DEF_FIELD(std::vector<StringRecord>, records)
+    )
+
+    DEF_OBJECT(Leaf,
+        DEF_FIELD(double, value)
+        DEF_FIELD(std::string, label)
+    )
+
+#define CORPUS_NESTED_LEVEL(name, inner)                \
+    DEF_OBJECT(name,                                    \
+        DEF_FIELD(double, depth)                        \
+        DEF_FIELD(std::vector<std::vector<double>>, m)  \
+        DEF_FIELD(inner, child)                         \
+    )
+
+    CORPUS_NESTED_LEVEL(Level1, Leaf)
+    CORPUS_NESTED_LEVEL(Level2, Level1)
+    CORPUS_NESTED_LEVEL(Level3, Level2)
+    CORPUS_NESTED_LEVEL(Level4, Level3)
+    CORPUS_NESTED_LEVEL(Level5, Level4)
+    CORPUS_NESTED_LEVEL(Level6, Level5)
+    CORPUS_NESTED_LEVEL(Level7, Level6)
+    CORPUS_NESTED_LEVEL(Level8, Level7)
+
+#undef CORPUS_NESTED_LEVEL
+
+    DEF_OBJECT(Nested,
+        DEF_FIELD(std::vector<Level8>, records)
+    )
+
+    DEF_OBJECT(WideRecord,
+        DEF_FIELD(std::string,  f00) DEF_FIELD(double, f01) DEF_FIELD(double, f02) DEF_FIELD(std::string, f03)
+        DEF_FIELD(double,       f04) DEF_FIELD(double, f05) DEF_FIELD(double, f06) DEF_FIELD(std::string, f07)
+        DEF_FIELD(double,       f08) DEF_FIELD(double, f09) DEF_FIELD(double, f10) DEF_FIELD(std::string, f11)
+        DEF_FIELD(double,       f12) DEF_FIELD(double, f13) DEF_FIELD(double, f14) DEF_FIELD(std::string, f15)
+        DEF_FIELD(double,       f16) DEF_FIELD(double, f17) DEF_FIELD(double, f18) DEF_FIELD(std::string, f19)
+        DEF_FIELD(double,       f20) DEF_FIELD(double, f21) DEF_FIELD(double, f22) DEF_FIELD(std::string, f23)
+        DEF_FIELD(double,       f24) DEF_FIELD(double, f25) DEF_FIELD(double, f26) DEF_FIELD(std::string, f27)
+        DEF_FIELD(double,       f28) DEF_FIELD(double, f29) DEF_FIELD(double, f30) DEF_FIELD(std::string, f31)
+    )
+
+    DEF_OBJECT(Wide,
+        DEF_FIELD(std::vector<WideRecord>, records)
+    )
+
+    // Polymorphic elements shaped like the ones in examples/heterogeneous.cpp.
+    struct Element : jco::serialization::ISerializable
+    {
+        virtual std::size_t weight() const = 0;
+    };
+
+    typedef std::unique_ptr<Element> ElementPtr;
+
+    struct Point : Element
+    {
+        static constexpr const char * JCO_CLASS_NAME = "corpus::Point";
+
+        double x, y;
+        std::string name;
+
+        static ElementPtr from_jco(jco::Parser &);
+        static jco::pooled_ptr<Element> from_jco_pooled(jco::Parser &, jco::ParseContext &);
+        void serialize(jco::serialization::out_stream &) const override;
+        std::size_t weight() const override { return name.size(); }
+    };
+
+    struct Label : Element
+    {
+        static constexpr const char * JCO_CLASS_NAME = "corpus::Label";
+
+        std::string a;
+        double b;
+
+        static ElementPtr from_jco(jco::Parser &);
+        static jco::pooled_ptr<Element> from_jco_pooled(jco::Parser &, jco::ParseContext &);
+        void serialize(jco::serialization::out_stream &) const override;
+        std::size_t weight() const override { return a.size(); }
+    };
+
+    typedef std::vector<ElementPtr> Heterogeneous;
+
+    // The same elements as values, for arrays of variants (jco/variant.h).
+    DEF_OBJECT(PointValue,
+        DEF_FIELD(double, x)
+        DEF_FIELD(double, y)
+        DEF_FIELD(std::string, name)
+    )
+    DEF_TYPE_NAME(PointValue, "corpus::Point")
+
+    DEF_OBJECT(LabelValue,
+        DEF_FIELD(std::string, a)
+        DEF_FIELD(double, b)
+    )
+    DEF_TYPE_NAME(LabelValue, "corpus::Label")
+
+    typedef boost::variant<PointValue, LabelValue> ElementValue;
+
+    // registers both plain and pooled factories
+    void register_factories(jco::TypedParser<Element> &);
+
+    Numbers         make_numbers        (Random &, std::size_t approx_bytes);
+    Strings         make_strings        (Random &, std::size_t approx_bytes);
+    Nested          make_nested         (Random &, std::size_t approx_bytes);
+    Wide            make_wide           (Random &, std::size_t approx_bytes);
+    Heterogeneous   make_heterogeneous  (Random &, std::size_t approx_bytes);
+
+    void write(jco::serialization::out_stream &, Numbers const &);
+    void write(jco::serialization::out_stream &, Strings const &);
+    void write(jco::serialization::out_stream &, Nested const &);
+    void write(jco::serialization::out_stream &, Wide const &);
+    void write(jco::serialization::out_stream &, Heterogeneous const &);
+
+    template<class Doc>
+    std::string to_json(Doc const & doc, jco::serialization::Style style)
+    {
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, style);
+            write(out, doc);
+        }
+        return ss.str();
+    }
+}
@@ -13,6 +13,8 @@ public:
 public:                                                                                 \
     static constexpr const char * JCO_CLASS_NAME = #jconame;                            \
     static std::unique_ptr<classname> from_jco(jco::Parser &);                          \
+    static jco::pooled_ptr<classname> from_jco_pooled(jco::Parser &,                    \
+                                                      jco::ParseContext &);             \
     void serialize_descr(jco::serialization::out_stream &) const;                       \
     friend jco::serialization::out_stream & operator <<                                 \
         (jco::serialization::out_stream & out, classname const & o)                     \
@@ -30,8 +32,9 @@ public:
         out << *this;                                                                   \
     }                                                                                   \
 
-#define REGISTER_JCO_FACTORY(parser, classname) \
-    parser.register_factory(classname::JCO_CLASS_NAME, &classname::from_jco);
+#define REGISTER_JCO_FACTORY(parser, classname)                                         \
+    parser.register_factory(classname::JCO_CLASS_NAME, &classname::from_jco);           \
+    parser.register_pooled_factory(classname::JCO_CLASS_NAME, &classname::from_jco_pooled);
 
 namespace mynamespace
 {
@@ -73,6 +76,12 @@ namespace mynamespace
         return std::make_unique<Impl1>(std::move(jr.a), jr.b);
     }
 
+    jco::pooled_ptr<Impl1> Impl1::from_jco_pooled(jco::Parser & parser, jco::ParseContext & ctx)
+    {
+        auto jr = parser.parse<details1::jco_repr>();
+        return ctx.make<Impl1>(std::move(jr.a), jr.b);
+    }
+
     void Impl1::serialize_descr(jco::serialization::out_stream & out) const
     {
         using namespace jco::serialization;
@@ -125,6 +134,12 @@ namespace mynamespace
         return std::make_unique<Impl2>(jr.x, jr.y, std::move(jr.name));
     }
 
+    jco::pooled_ptr<Impl2> Impl2::from_jco_pooled(jco::Parser & parser, jco::ParseContext & ctx)
+    {
+        auto jr = parser.parse<details2::jco_repr>();
+        return ctx.make<Impl2>(jr.x, jr.y, std::move(jr.name));
+    }
+
     void Impl2::serialize_descr(jco::serialization::out_stream & out) const
     {
         using namespace jco::serialization;
@@ -188,6 +203,28 @@ void parse_array()
     });
 }
 
+void parse_array_pooled()
+{
+    typedef jco::pooled_ptr<IMyInterface> IMyInterfacePtr;
+
+    auto str = "[{\"type\" : \"mynamespace::Impl1\", \"description\" : { \"a\" : \"AAA\", \"b\" : 239 } },"
+                "{\"type\" : \"mynamespace::Impl1\", \"description\" : { \"a\" : \"BBB\", \"b\" : 566 } }]";
+
+    jco::TypedParser<IMyInterface> parser;
+    REGISTER_JCO_FACTORY(parser, mynamespace::Impl1);
+    REGISTER_JCO_FACTORY(parser, mynamespace::Impl2);
+
+    // the objects sit next to each other in the context, it has to outlive them
+    jco::ParseContext ctx;
+    std::vector<IMyInterfacePtr> objects;
+    parser.parse_array(jco::from_string(str), ctx, [&objects] (IMyInterfacePtr obj) {
+        objects.push_back(std::move(obj));
+    });
+
+    for (auto const & obj : objects)
+        std::cout << obj->to_string() << std::endl;
+}
+
 int main()
 {
     print_separator();
@@ -227,4 +264,8 @@ int main()
     print_separator();
 
     parse_array();
+
+    print_separator();
+
+    parse_array_pooled();
 }
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "parser.h"
+#include "serialization.h"
+
+namespace jco
+{
+    // Bytes written in JSON as a base64 string (RFC 4648, padded). Both
+    // padded and unpadded strings are read.
+    struct binary
+    {
+        std::vector<std::uint8_t> bytes;
+
+        friend bool operator == (binary const & a, binary const & b) { return a.bytes == b.bytes; }
+        friend bool operator != (binary const & a, binary const & b) { return a.bytes != b.bytes; }
+    };
+
+    namespace details
+    {
+        inline std::size_t base64_encoded_size(std::size_t size)
+        {
+            return (size + 2) / 3 * 4;
+        }
+
+        // Writes base64_encoded_size(size) symbols, returns their count.
+        std::size_t base64_encode(std::uint8_t const * in, std::size_t size, char * out);
+
+        // Replaces the content of out, false if the text isn't base64.
+        bool base64_decode(const char * in, std::size_t size, std::vector<std::uint8_t> & out);
+
+        // Decodes a string right from the text, unless it has escape sequences.
+        bool read_base64(ParserState &, std::vector<std::uint8_t> & out);
+
+        template<>
+        struct expected_token_impl<binary>
+        {
+            static const Token value = Token::Quote;
+        };
+
+        template<>
+        inline bool parse<binary>(ParserState & st, binary & out)
+        {
+            return read_base64(st, out.bytes);
+        }
+
+        template<>
+        inline void clear<binary>(binary & value)
+        {
+            value.bytes.clear();
+        }
+    }
+
+    namespace serialization
+    {
+        inline base64_tag base64(std::vector<std::uint8_t> const & bytes)
+        {
+            return base64(bytes.data(), bytes.size());
+        }
+
+        namespace details
+        {
+            template<>
+            struct value_writer<binary>
+            {
+                static void field(out_stream & out, binary const & b)      { out << value(base64(b.bytes)); }
+                static void element(out_stream & out, binary const & b)    { out << base64(b.bytes); }
+            };
+        }
+    }
+}
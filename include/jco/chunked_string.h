@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "parser.h"
+
+namespace jco
+{
+    // A string field for huge values, e.g. embedded documents or logs, which
+    // shouldn't be kept in memory: the content is handed to sink as it is
+    // decoded, in chunks of at most chunk_size bytes; chunk_size is raised
+    // to 8 if it's less, the room a decoded escape sequence may need. A chunk
+    // never ends inside of a UTF-8 sequence or of a decoded escape sequence.
+    // Without a sink the content is only counted. The sink may parse other
+    // documents, also with chunked strings. Parsing over an object keeps the
+    // sink, so it's set once before jco::parse_into. Isn't serialized.
+    struct chunked_string
+    {
+        std::function<void (boost::string_ref)> sink;
+        std::size_t                             chunk_size  = 64 * 1024;
+
+        // decoded bytes of the last value
+        std::size_t                             size        = 0;
+    };
+
+    namespace details
+    {
+        template<>
+        struct expected_token_impl<chunked_string>
+        {
+            static const Token value = Token::Quote;
+        };
+
+        template<>
+        inline bool parse<chunked_string>(ParserState & st, chunked_string & out)
+        {
+            return read_string_chunks(st, out.chunk_size, out.sink, out.size);
+        }
+
+        template<>
+        inline void clear<chunked_string>(chunked_string & value)
+        {
+            value.size = 0;
+        }
+    }
+}
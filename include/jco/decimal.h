@@ -0,0 +1,18 @@
+#pragma once
+
+namespace jco
+{
+    // Number written with exactly Digits digits after the decimal point, e.g.
+    // coordinates or money. Read as any other number, the value is a double.
+    template<unsigned Digits>
+    struct decimal
+    {
+        decimal(double value = 0)
+            : value(value)
+        {}
+
+        operator double() const { return value; }
+
+        double value;
+    };
+}
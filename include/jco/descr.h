@@ -1,10 +1,21 @@
 #pragma once
 
+#ifndef BOOST_PP_VARIADICS
 #define BOOST_PP_VARIADICS
+#endif
 
 #include <boost/preprocessor/facilities/overload.hpp>
 #include <boost/preprocessor/seq/for_each.hpp>
 #include <boost/preprocessor/seq/for_each_i.hpp>
+#include <boost/preprocessor/seq/size.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include "parser.h"
+#include "serialization.h"
 
 #define DEF_FIELD_2(type, ct_name) \
     DEF_FIELD_3(type, ct_name, #ct_name)
@@ -38,8 +49,163 @@
     {                                                       \
         BOOST_PP_SEQ_FOR_EACH(CALL, fake_data, fields)      \
     }                                                       \
+                                                            \
+    template<class F>                                       \
+    void for_each(struct_name const & s, F f)               \
+    {                                                       \
+        BOOST_PP_SEQ_FOR_EACH(CALL, fake_data, fields)      \
+    }                                                       \
+
+#define NAME_FIELD(r, data, elem) boost::string_ref(GET_RT_NAME(elem)),
+
+#define CALL_BY_INDEX(r, data, i, elem) \
+    case i: f(s.GET_CT_NAME(elem), GET_RT_NAME(elem)); break;
+
+// Fields by index in the order of declaration, used by the parser to match
+// keys without walking all the fields. Found by ADL on a null pointer.
+#define DEFINE_FIELDS_INFO(struct_name, fields)                             \
+    constexpr std::size_t fields_count(struct_name const *)                 \
+    {                                                                       \
+        return BOOST_PP_SEQ_SIZE(fields);                                   \
+    }                                                                       \
+                                                                            \
+    inline boost::string_ref const * field_names(struct_name const *)       \
+    {                                                                       \
+        static const boost::string_ref names[] = {                          \
+            BOOST_PP_SEQ_FOR_EACH(NAME_FIELD, fake_data, fields)            \
+        };                                                                  \
+        return names;                                                       \
+    }                                                                       \
+                                                                            \
+    template<class F>                                                       \
+    void visit_field(struct_name & s, std::size_t index, F f)               \
+    {                                                                       \
+        switch (index)                                                      \
+        {                                                                   \
+            BOOST_PP_SEQ_FOR_EACH_I(CALL_BY_INDEX, fake_data, fields)       \
+        }                                                                   \
+    }
+
+// Structures with fields like std::unordered_map aren't standard layout, but
+// without virtual bases offsetof works for them with GCC and Clang.
+#if defined(__GNUC__)
+#define JCO_OFFSETOF_BEGIN                                          \
+    _Pragma("GCC diagnostic push")                                  \
+    _Pragma("GCC diagnostic ignored \"-Winvalid-offsetof\"")
+#define JCO_OFFSETOF_END                                            \
+    _Pragma("GCC diagnostic pop")
+#else
+#define JCO_OFFSETOF_BEGIN
+#define JCO_OFFSETOF_END
+#endif
+
+#define DESCRIBE_FIELD(r, struct_name, elem)                                            \
+    { boost::string_ref(GET_RT_NAME(elem)), offsetof(struct_name, GET_CT_NAME(elem)),   \
+      ::jco::details::field_type_of<GET_TYPE(elem)>::value,                             \
+      &::jco::details::field_ops_of<GET_TYPE(elem)>::value },
+
+// Descriptors of the fields for the table-driven decoder. A template, so
+// the functions reading the fields are only instantiated when it's used.
+#define DEFINE_FIELD_TABLE(struct_name, fields)                                     \
+    JCO_OFFSETOF_BEGIN                                                              \
+    template<class Self>                                                            \
+    typename std::enable_if<std::is_same<Self, struct_name>::value,                 \
+                            ::jco::details::field_descriptor const *>::type         \
+    field_table(Self const *)                                                       \
+    {                                                                               \
+        static const ::jco::details::field_descriptor table[] = {                  \
+            BOOST_PP_SEQ_FOR_EACH(DESCRIBE_FIELD, struct_name, fields)              \
+        };                                                                          \
+        return table;                                                               \
+    }                                                                               \
+    JCO_OFFSETOF_END
+
+#define DEFINE_DECODING(struct_name, by_table)                      \
+    constexpr bool decode_by_table(struct_name const *)             \
+    {                                                               \
+        return by_table;                                            \
+    }
+
+#define DEF_OBJECT_IMPL(name, fields, by_table) \
+    DEFINE_STRUCT_IMPL(name, fields)            \
+    DEFINE_FOREACH(name, fields)                \
+    DEFINE_FIELDS_INFO(name, fields)            \
+    DEFINE_FIELD_TABLE(name, fields)            \
+    DEFINE_DECODING(name, by_table)
+
+// Objects are parsed either by code generated for each type or by a single
+// decoder shared by all the types, which interprets tables of their fields.
+// The shared one keeps the code small when there are lots of types, the
+// generated one is faster. DEF_OBJECT takes the build default, set by
+// JCO_TABLE_DECODING, the other two choose for the type.
+
+#ifdef JCO_TABLE_DECODING
+#define DEF_OBJECT(name, fields) DEF_OBJECT_IMPL(name, fields, true)
+#else
+#define DEF_OBJECT(name, fields) DEF_OBJECT_IMPL(name, fields, false)
+#endif
+
+#define DEF_TABLE_OBJECT(name, fields)  DEF_OBJECT_IMPL(name, fields, true)
+#define DEF_HOT_OBJECT(name, fields)    DEF_OBJECT_IMPL(name, fields, false)
+
+
+// Name of a type in the "type" key of elements of heterogeneous arrays,
+// which are parsed into boost::variant of the types (see jco/variant.h).
+#define DEF_TYPE_NAME(type, rt_name)                        \
+    inline boost::string_ref type_name(type const *)        \
+    {                                                       \
+        return boost::string_ref(rt_name);                  \
+    }
+
+
+#define DEF_VALUE_1(ct_name) \
+    DEF_VALUE_2(ct_name, #ct_name)
+
+#define DEF_VALUE_2(ct_name, rt_name) \
+    ((ct_name, rt_name))
+
+// An enumerator of DEF_ENUM, spelled in JSON as rt_name (a string literal).
+#define DEF_VALUE(...) BOOST_PP_OVERLOAD(DEF_VALUE_,__VA_ARGS__)(__VA_ARGS__)
+
+#define GET_ENUM_CT_NAME(value) BOOST_PP_TUPLE_ELEM(0, value)
+#define GET_ENUM_RT_NAME(value) BOOST_PP_TUPLE_ELEM(1, value)
+#define GET_ENUM_RT_SIZE(value) (sizeof(GET_ENUM_RT_NAME(value)) - 1)
+
+#define DECLARE_ENUM_VALUE(r, data, elem) GET_ENUM_CT_NAME(elem),
+
+#define MATCH_ENUM_VALUE(r, enum_name, elem)                                    \
+    if ((str.size() == GET_ENUM_RT_SIZE(elem)) &&                               \
+        (std::memcmp(str.data(), GET_ENUM_RT_NAME(elem), str.size()) == 0))     \
+    {                                                                           \
+        value = enum_name::GET_ENUM_CT_NAME(elem);                              \
+        return true;                                                            \
+    }
 
-#define DEF_OBJECT(name, fields)        \
-    DEFINE_STRUCT_IMPL(name, fields)    \
-    DEFINE_FOREACH(name, fields)
+#define NAME_ENUM_VALUE(r, data, elem) \
+    boost::string_ref(GET_ENUM_RT_NAME(elem), GET_ENUM_RT_SIZE(elem)),
 
+// Enum class with the JSON spellings of its values, usable as a DEF_OBJECT
+// field. Spellings are compared with the raw bytes of the input by a chain
+// of fixed size comparisons and written from a static table.
+#define DEF_ENUM(name, values)                                                  \
+    enum class name                                                             \
+    {                                                                           \
+        BOOST_PP_SEQ_FOR_EACH(DECLARE_ENUM_VALUE, fake_data, values)            \
+    };                                                                          \
+                                                                                \
+    inline bool enum_from_string(boost::string_ref str, name & value)           \
+    {                                                                           \
+        BOOST_PP_SEQ_FOR_EACH(MATCH_ENUM_VALUE, name, values)                   \
+        return false;                                                           \
+    }                                                                           \
+                                                                                \
+    inline boost::string_ref enum_to_string(name value)                         \
+    {                                                                           \
+        static const boost::string_ref names[] = {                              \
+            BOOST_PP_SEQ_FOR_EACH(NAME_ENUM_VALUE, fake_data, values)           \
+        };                                                                      \
+        auto index = static_cast<std::size_t>(value);                           \
+        if (index >= BOOST_PP_SEQ_SIZE(values))                                 \
+            throw ::jco::SerializationError();                                  \
+        return names[index];                                                    \
+    }
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+namespace jco
+{
+    // Text of a value found by PathExtractor, it points into the document.
+    struct RawValue
+    {
+        // Quote, Number, Constant, ObjBegin or ArrBegin; EOT if the path wasn't found
+        details::Token      kind = details::Token::EOT;
+        boost::string_ref   raw;
+
+        bool found() const { return kind != details::Token::EOT; }
+
+        // strings without quotes (escape sequences are kept), other values as is
+        boost::string_ref view() const
+        {
+            return (kind == details::Token::Quote) ? raw.substr(1, raw.size() - 2) : raw;
+        }
+
+        // parses the value as any type supported by jco::parse
+        template<class T>
+        T as() const
+        {
+            if (!found())
+                throw ParseError(ParseErrorCode::UnexpectedEnd, 0);
+
+            details::ParserState st(from_string(raw), 0);
+            return details::parse<T>(st);
+        }
+    };
+
+    // Finds values by JSON pointers (RFC 6901), e.g. "/meta/id" or "/items/3/price",
+    // without parsing anything else: values off the requested paths are skipped
+    // and reading stops as soon as all of them are found.
+    class PathExtractor
+    {
+    public:
+        explicit PathExtractor(std::vector<std::string> const & pointers);
+        ~PathExtractor();
+
+        // one value per pointer, in the order of pointers
+        std::vector<RawValue> extract(utf8_text const & txt) const;
+
+        struct Node;
+
+    private:
+        std::unique_ptr<Node>   root_;
+        std::size_t             pointers_num_;
+    };
+
+    inline RawValue extract(utf8_text const & txt, std::string const & pointer)
+    {
+        return PathExtractor({ pointer }).extract(txt).front();
+    }
+
+    // Streams the elements of an array found by a JSON pointer, e.g. "/data"
+    // of { "meta" : {...}, "data" : [...] }. Values before the array are
+    // skipped, and elements are parsed one at a time, so memory doesn't grow
+    // with the array. Reading stops at the end of the array, the rest of the
+    // document isn't looked at.
+    //
+    //  ArrayCursor cursor(txt, "/data");
+    //  Element e;
+    //  while (cursor.next())
+    //      cursor.read(e);
+    class ArrayCursor
+    {
+    public:
+        // throws ParseError if the value at the pointer isn't an array
+        ArrayCursor(utf8_text const & txt, std::string const & pointer, ParseOptions const & options = ParseOptions());
+
+        // false if the document has no value at the pointer, then there are no elements
+        bool found() const { return found_; }
+
+        // Moves to the next element, false after the last one. The element
+        // has to be read or skipped before the next call.
+        bool next();
+
+        // parses the element over out, reusing its memory as jco::parse_into
+        template<class T>
+        void read(T & out) { parser_.parse_into(out); }
+
+        template<class T>
+        T read() { return parser_.parse<T>(); }
+
+        void skip() { parser_.skip_value(); }
+
+        // for elements read by other means, e.g. TypedParser::parse_element
+        Parser & parser() { return parser_; }
+
+    private:
+        enum class State
+        {
+            First, Next, End
+        };
+
+        Parser  parser_;
+        bool    found_;
+        State   state_;
+    };
+}
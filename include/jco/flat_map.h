@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/utility/string_ref.hpp>
+
+namespace jco
+{
+    // Map with string keys kept as a vector of pairs sorted by key: lookups
+    // are binary searches over contiguous storage. Insertion of a single
+    // element is linear, the parser fills the storage and sorts it once.
+    template<class Value>
+    class flat_map
+    {
+    public:
+        typedef std::pair<std::string, Value>               value_type;
+        typedef std::vector<value_type>                     storage_type;
+        typedef typename storage_type::iterator             iterator;
+        typedef typename storage_type::const_iterator       const_iterator;
+
+        iterator        begin()         { return items_.begin(); }
+        iterator        end()           { return items_.end(); }
+        const_iterator  begin() const   { return items_.begin(); }
+        const_iterator  end() const     { return items_.end(); }
+
+        std::size_t size() const    { return items_.size(); }
+        bool        empty() const   { return items_.empty(); }
+
+        void clear()                    { items_.clear(); }
+        void reserve(std::size_t n)     { items_.reserve(n); }
+
+        iterator find(boost::string_ref key)
+        {
+            auto it = lower_bound(key);
+            return ((it != items_.end()) && (it->first == key)) ? it : items_.end();
+        }
+
+        const_iterator find(boost::string_ref key) const
+        {
+            return const_cast<flat_map *>(this)->find(key);
+        }
+
+        std::size_t count(boost::string_ref key) const
+        {
+            return (find(key) != end()) ? 1 : 0;
+        }
+
+        Value & operator [] (boost::string_ref key)
+        {
+            auto it = lower_bound(key);
+            if ((it == items_.end()) || (it->first != key))
+                it = items_.insert(it, value_type(key.to_string(), Value()));
+            return it->second;
+        }
+
+        // Direct access to the storage; sort() has to be called after keys are changed.
+        storage_type & items() { return items_; }
+
+        // Restores the order by key, of equal keys the last one is kept.
+        void sort()
+        {
+            auto less = [] (value_type const & a, value_type const & b) { return a.first < b.first; };
+            // usually the keys are already in order, e.g. written from a flat_map
+            auto out_of_order = [&less] (value_type const & a, value_type const & b) { return !less(a, b); };
+            if (std::adjacent_find(items_.begin(), items_.end(), out_of_order) == items_.end())
+                return;
+
+            std::stable_sort(items_.begin(), items_.end(), less);
+
+            auto dest = items_.begin();
+            for (auto it = items_.begin(); it != items_.end(); ++it)
+            {
+                auto next = it + 1;
+                if ((next != items_.end()) && (next->first == it->first))
+                    continue;
+                if (dest != it)
+                    *dest = std::move(*it);
+                ++dest;
+            }
+            items_.erase(dest, items_.end());
+        }
+
+    private:
+        iterator lower_bound(boost::string_ref key)
+        {
+            return std::lower_bound(items_.begin(), items_.end(), key, [] (value_type const & item, boost::string_ref key) {
+                return boost::string_ref(item.first) < key;
+            });
+        }
+
+    private:
+        storage_type items_;
+    };
+}
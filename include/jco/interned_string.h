@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include <boost/utility/string_ref.hpp>
+
+#include "parser.h"
+#include "serialization.h"
+
+namespace jco
+{
+    // Immutable string shared by all the equal ones, so copies are cheap and
+    // comparison is a comparison of pointers. Strings are kept in a global
+    // table for the lifetime of the program, interning is thread safe.
+    // Meant for fields with few distinct values: codes, names, types.
+    class interned_string
+    {
+    public:
+        // the empty string
+        interned_string();
+
+        explicit interned_string(boost::string_ref str);
+
+        std::string const & str() const { return *str_; }
+
+        boost::string_ref view() const { return *str_; }
+
+        const char * c_str() const { return str_->c_str(); }
+
+        std::size_t size() const { return str_->size(); }
+
+        bool empty() const { return str_->empty(); }
+
+        friend bool operator == (interned_string a, interned_string b) { return a.str_ == b.str_; }
+        friend bool operator != (interned_string a, interned_string b) { return a.str_ != b.str_; }
+
+    private:
+        std::string const * str_;
+    };
+
+    namespace details
+    {
+        template<>
+        struct expected_token_impl<interned_string>
+        {
+            static const Token value = Token::Quote;
+        };
+
+        // strings without escape sequences are looked up right in the text
+        template<>
+        inline bool parse<interned_string>(ParserState & st, interned_string & out)
+        {
+            thread_local std::string buffer;
+
+            boost::string_ref str;
+            if (!read_string_ref(st, buffer, str))
+                return false;
+            out = interned_string(str);
+            return true;
+        }
+
+        template<>
+        inline void clear<interned_string>(interned_string & value)
+        {
+            value = interned_string();
+        }
+    }
+
+    namespace serialization
+    {
+        namespace details
+        {
+            template<>
+            struct value_writer<interned_string>
+            {
+                static void field(out_stream & out, interned_string s)      { out << value(s.str()); }
+                static void element(out_stream & out, interned_string s)    { out << s.view(); }
+            };
+        }
+    }
+}
+
+namespace std
+{
+    template<>
+    struct hash<jco::interned_string>
+    {
+        std::size_t operator() (jco::interned_string s) const
+        {
+            return hash<std::string const *>()(&s.str());
+        }
+    };
+}
@@ -1,5 +1,14 @@
 #pragma once
 
+#include "stats.h"
 #include "parser.h"
 #include "descr.h"
 #include "serialization.h"
+#include "json_lines.h"
+#include "extract.h"
+#include "validate.h"
+#include "interned_string.h"
+#include "base64.h"
+#include "variant.h"
+#include "lazy.h"
+#include "chunked_string.h"
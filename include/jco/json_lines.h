@@ -0,0 +1,159 @@
+#pragma once
+
+#include <exception>
+#include <istream>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <type_traits>
+
+#include "parser.h"
+#include "serialization.h"
+
+namespace jco
+{
+    struct JsonLinesOptions
+    {
+        // amount of input handed to a worker at once, lines longer than that
+        // get a block of their own
+        std::size_t block_size  = 1 << 20;
+
+        // parsing threads, 0 means std::thread::hardware_concurrency()
+        std::size_t threads     = 0;
+
+        // blocks which are read but not delivered yet, 0 means 2 * threads;
+        // together with block_size bounds the memory used by the reader
+        std::size_t max_blocks  = 0;
+    };
+
+    namespace details
+    {
+        struct LinesBlock
+        {
+            std::vector<utf8_text> lines;
+        };
+
+        // Called on the consumer thread in the order of blocks.
+        typedef std::function<void ()>                          Delivery;
+        typedef std::function<Delivery (LinesBlock const &)>    BlockDecoder;
+
+        void run_json_lines(std::istream & in,        JsonLinesOptions const &, BlockDecoder);
+        void run_json_lines(utf8_text const & txt,    JsonLinesOptions const &, BlockDecoder);
+
+        template<class Res, class Source, class Decoder>
+        void read_json_lines(Source & src, Decoder decoder, std::function<void (Res)> const & proc,
+                             JsonLinesOptions const & options)
+        {
+            run_json_lines(src, options, [&decoder, &proc] (LinesBlock const & block) -> Delivery {
+                std::shared_ptr<std::vector<Res>> res(new std::vector<Res>);
+                res->reserve(block.lines.size());
+
+                // the lines before a failing one are still delivered
+                std::exception_ptr error;
+                try
+                {
+                    for (auto const & line : block.lines)
+                        res->push_back(decoder(line));
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                return [res, error, &proc] {
+                    for (auto & r : *res)
+                        proc(std::move(r));
+                    if (error)
+                        std::rethrow_exception(error);
+                };
+            });
+        }
+    }
+
+    // Parses newline delimited JSON (one document per line, blank lines are
+    // ignored) on a pool of threads. proc is called on the calling thread,
+    // in the order of lines. A ParseError of any line is rethrown after all
+    // the preceding lines have been delivered.
+
+    template<class Res>
+    void read_json_lines(std::istream & in, std::function<void (Res)> const & proc,
+                         JsonLinesOptions const & options = JsonLinesOptions())
+    {
+        details::read_json_lines<Res>(in, [] (utf8_text const & line) { return parse<Res>(line); }, proc, options);
+    }
+
+    template<class Res>
+    void read_json_lines(utf8_text const & txt, std::function<void (Res)> const & proc,
+                         JsonLinesOptions const & options = JsonLinesOptions())
+    {
+        details::read_json_lines<Res>(txt, [] (utf8_text const & line) { return parse<Res>(line); }, proc, options);
+    }
+
+    // Factories of the parser are called concurrently.
+    template<class T, class Source>
+    void read_json_lines(Source & src, TypedParser<T> const & parser,
+                         std::function<void (typename TypedParser<T>::TPtr)> const & proc,
+                         JsonLinesOptions const & options = JsonLinesOptions())
+    {
+        auto decoder = [&parser] (utf8_text const & line) {
+            ParseStats stats;
+            return parser.parse_single(line, stats);
+        };
+        details::read_json_lines<typename TypedParser<T>::TPtr>(src, decoder, proc, options);
+    }
+
+    struct JsonLinesWriterOptions
+    {
+        // a producer's buffer is committed early once it holds that many bytes
+        std::size_t buffer_size         = 1 << 16;
+
+        // otherwise the commit thread writes everything that period (milliseconds)
+        std::size_t commit_interval_ms  = 10;
+    };
+
+    // Writes single line documents, one per line, appended from any number of
+    // threads. Every producer thread serializes into a buffer of its own, a
+    // background thread periodically takes the buffers over and writes them
+    // to the stream, so producers don't wait for each other. Lines of one
+    // thread keep their order, lines of different threads are interleaved.
+    class JsonLinesWriter
+    {
+    public:
+        explicit JsonLinesWriter(std::ostream & out, JsonLinesWriterOptions const & options = JsonLinesWriterOptions());
+
+        // commits everything appended so far
+        ~JsonLinesWriter();
+
+        JsonLinesWriter(JsonLinesWriter const &) = delete;
+        JsonLinesWriter& operator = (JsonLinesWriter const &) = delete;
+
+        void append(serialization::ISerializable const & obj);
+
+        // DEF_OBJECT structures, see serialization::write
+        template<class T>
+        typename std::enable_if<!std::is_base_of<serialization::ISerializable, T>::value>::type
+        append(T const & obj)
+        {
+            append_record(&write_record<T>, &obj);
+        }
+
+        // Blocks until everything appended before the call is written to the
+        // stream, throws std::ios_base::failure if writing failed.
+        void flush();
+
+    private:
+        typedef void (*RecordWriter)(serialization::out_stream &, void const *);
+
+        template<class T>
+        static void write_record(serialization::out_stream & out, void const * obj)
+        {
+            serialization::write(out, *static_cast<T const *>(obj));
+        }
+
+        void append_record(RecordWriter, void const * obj);
+
+    private:
+        struct implementation;
+        std::unique_ptr<implementation> pimpl;
+    };
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "parser.h"
+#include "serialization.h"
+
+namespace jco
+{
+    // An element of TypedParser parsed only up to its type: the description
+    // keeps its text and is parsed by the factory when the object is accessed
+    // for the first time. Written to a stream, the original text of the
+    // description is forwarded as is, also after the object was accessed.
+    // Refers to the parsed text and to the TypedParser that made it, both
+    // have to outlive the object.
+    template<class T>
+    class lazy_object
+    {
+    public:
+        typedef std::unique_ptr<T>              TPtr;
+        typedef std::function<TPtr (Parser &)>  Factory;
+
+        lazy_object()
+            : txt_{ nullptr, 0 }
+            , type_(nullptr)
+            , factory_(nullptr)
+        {}
+
+        lazy_object(utf8_text const & txt, boost::string_ref description, std::string const & type, Factory const & factory)
+            : txt_(txt)
+            , description_(description)
+            , type_(&type)
+            , factory_(&factory)
+        {}
+
+        boost::string_ref type() const { return *type_; }
+
+        // text of the description as it is in the input
+        boost::string_ref description() const { return description_; }
+
+        bool parsed() const { return bool(object_); }
+
+        // parses the description on the first call, offsets of parse errors
+        // are counted from the beginning of the whole text
+        T & get() const
+        {
+            if (!object_)
+            {
+                if (!*factory_)
+                    throw std::logic_error("type has only a pooled factory, parse it with a context");
+
+                Parser parser(txt_);
+                parser.seek(description_.data() - txt_.data);
+                object_ = (*factory_)(parser);
+            }
+            return *object_;
+        }
+
+        T & operator * () const     { return get(); }
+        T * operator -> () const    { return &get(); }
+
+        // parses the description unless it was parsed and gives the object away
+        TPtr release()
+        {
+            get();
+            return std::move(object_);
+        }
+
+    private:
+        // point into the text and into the factories of the TypedParser
+        utf8_text           txt_;
+        boost::string_ref   description_;
+        std::string const * type_;
+        Factory const *     factory_;
+        mutable TPtr        object_;
+    };
+
+    namespace serialization
+    {
+        namespace details
+        {
+            template<class T>
+            struct value_writer<lazy_object<T>>
+            {
+                static void field(out_stream & out, lazy_object<T> const & x)
+                {
+                    out << value(object);
+                    element(out, x);
+                }
+
+                static void element(out_stream & out, lazy_object<T> const & x)
+                {
+                    object_scope os(out);
+                    out << key("type")          << value(x.type())
+                        << key("description")   << value(raw(x.description()));
+                }
+            };
+        }
+    }
+}
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <vector>
 #include <string>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <bitset>
 #include <functional>
 #include <cassert>
 #include <cstring>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 #include <boost/utility/string_ref.hpp>
+#include <boost/variant/variant_fwd.hpp>
+
+#include "stats.h"
+#include "flat_map.h"
+#include "decimal.h"
+#include "pool.h"
 
 namespace jco
 {
@@ -23,17 +36,106 @@ namespace jco
         return { str.cbegin(), str.size() };
     }
 
+    enum class ParseErrorCode
+    {
+        None,
+        UnexpectedEnd,      // the text ends inside of a value
+        InvalidSymbol,      // a symbol that doesn't start any token
+        UnexpectedToken,    // a valid token at a wrong place
+        InvalidNumber,
+        NumberOutOfRange,   // an integer that doesn't fit its type
+        InvalidEscape,
+        InvalidConstant,
+        InvalidUtf8,
+        InvalidBase64,      // a string of a jco::binary field
+        UnknownEnumValue,   // a string that isn't a spelling of a DEF_ENUM value
+        UnknownType,        // a type of a boost::variant element that isn't among its alternatives
+        TooDeep,            // see ParseOptions::max_depth
+        MissingField,       // see ParseOptions::require_all_fields
+        TrailingData        // something after the end of the document
+    };
+
+    // Result of the non-throwing parsing, offset is in bytes from the beginning of the text.
+    struct ParseStatus
+    {
+        ParseStatus()
+            : code(ParseErrorCode::None)
+            , offset(0)
+        {}
+
+        ParseStatus(ParseErrorCode code, std::size_t offset, boost::string_ref field = boost::string_ref())
+            : code(code)
+            , offset(offset)
+            , field(field)
+        {}
+
+        explicit operator bool() const { return code == ParseErrorCode::None; }
+
+        ParseErrorCode      code;
+        std::size_t         offset;
+        // name of the missing field, points to static storage
+        boost::string_ref   field;
+    };
+
+    struct ParseOptions
+    {
+        // every field of a DEF_OBJECT structure has to be present in the input
+        bool require_all_fields = false;
+
+        // deepest nesting of containers accepted in skipped values (counting
+        // the containers around them), deeper input fails with TooDeep
+        std::size_t max_depth = 1024;
+
+        // The input is known to be valid, e.g. it was written by jco itself:
+        // separators spelled as SingleLinePrinter does (" : ", ", ", " }")
+        // are taken without tokenizing, numbers and \u escapes aren't checked
+        // and skipped values are only scanned for their end (regardless of
+        // max_depth). Malformed input gives wrong values or errors at wrong
+        // offsets, but the text isn't read out of its bounds.
+        bool trusted = false;
+    };
+
     namespace details
     {
         struct ParserState
         {
-            utf8_text   txt;
-            std::size_t ptr;
+            ParserState(utf8_text const & txt, std::size_t ptr, ParseOptions const & options = ParseOptions())
+                : txt(txt)
+                , ptr(ptr)
+                , options(options)
+                , depth(0)
+            {}
+
+            utf8_text       txt;
+            std::size_t     ptr;
+            ParseOptions    options;
+
+            ParseStatus status;
+            ParseStats  stats;
+            std::size_t depth;
+        };
+
+        struct depth_guard
+        {
+            explicit depth_guard(ParserState & st)
+                : st_(st)
+            {
+                ++st_.depth;
+                JCO_STATS(st_.stats.max_depth = std::max(st_.stats.max_depth, st_.depth));
+            }
+
+            ~depth_guard()
+            {
+                --st_.depth;
+            }
+
+        private:
+            ParserState & st_;
         };
 
         enum class Token
         {
-            ObjBegin, ObjEnd, ArrBegin, ArrEnd, Comma, Colon, Quote, Number, Constant, EOT
+            ObjBegin, ObjEnd, ArrBegin, ArrEnd, Comma, Colon, Quote, Number, Constant, EOT, Error
         };
 
         enum class SSStatus
@@ -43,23 +145,92 @@ namespace jco
 
         SSStatus skip_spaces(ParserState & st);
 
+        void skip_BOM(ParserState & st);
+
+        // Records the error unless there is one already and returns false.
+        // Errors are propagated by returning false up to the public API.
+        bool fail(ParserState & st, ParseErrorCode code, std::size_t offset);
+        bool fail(ParserState & st, ParseErrorCode code);
+
+        // fails with the code matching the token that was just read
+        bool unexpected(ParserState & st, Token token);
+
+        bool expect_eot(ParserState & st);
+
+        [[noreturn]] void throw_error(ParseStatus const & status);
+
+        inline void check(ParserState const & st, bool ok)
+        {
+            if (!ok)
+                throw_error(st.status);
+        }
+
         template<class Res>
-        void parse(ParserState & st, Res & res);
+        bool parse(ParserState & st, Res & res);
+
+        template<class Element>
+        bool parse(ParserState & st, std::vector<Element> & out);
+
+        template<class Element, std::size_t N>
+        bool parse(ParserState & st, std::array<Element, N> & out);
+
+        template<class Value>
+        bool parse(ParserState & st, std::map<std::string, Value> & out);
+
+        template<class Value>
+        bool parse(ParserState & st, std::unordered_map<std::string, Value> & out);
+
+        template<class Value>
+        bool parse(ParserState & st, flat_map<Value> & out);
+
+        template<unsigned Digits>
+        bool parse(ParserState & st, decimal<Digits> & out);
+
+        // see jco/variant.h
+        template<class... Types>
+        bool parse(ParserState & st, boost::variant<Types...> & out);
 
         template<class Res>
         Res parse(ParserState & st)
         {
-            Res res;
-            parse(st, res);
+            Res res{};
+            check(st, parse(st, res));
             return res;
         }
     }
 
-    struct ParseError : std::exception {};
+    struct ParseError : std::exception
+    {
+        ParseError()
+            : code(ParseErrorCode::UnexpectedToken)
+            , offset(0)
+        {}
+
+        ParseError(ParseErrorCode code, std::size_t offset)
+            : code(code)
+            , offset(offset)
+        {}
+
+        const char * what() const noexcept override;
+
+        ParseErrorCode  code;
+        std::size_t     offset;
+    };
+
+    // thrown when ParseOptions::require_all_fields is set and an object lacks a field
+    struct MissingFieldError : ParseError
+    {
+        MissingFieldError(std::string field, std::size_t offset)
+            : ParseError(ParseErrorCode::MissingField, offset)
+            , field(std::move(field))
+        {}
+
+        std::string field;
+    };
 
     struct Parser
     {
-        explicit Parser(utf8_text const & txt);
+        explicit Parser(utf8_text const & txt, ParseOptions const & options = ParseOptions());
 
         template<typename Res>
         Res parse()
@@ -67,115 +238,409 @@ namespace jco
             return details::parse<Res>(st_);
         }
 
+        template<typename Res>
+        void parse_into(Res & res)
+        {
+            details::check(st_, details::parse(st_, res));
+        }
+
         std::string parse_string();
 
         bool eot();
 
+        // throws if anything but spaces is left
+        void expect_eot();
+
         void expect(details::Token);
         void expect(boost::string_ref str);
 
         details::Token next_token();
 
+        // skips a value of any kind
+        void skip_value();
+
+        // skips a value and returns its text as is, without surrounding spaces
+        boost::string_ref raw_value();
+
+        // offset in the text, e.g. to come back to a skipped value with seek
+        std::size_t position() const { return st_.ptr; }
+        void seek(std::size_t position) { st_.ptr = position; }
+
+        utf8_text const & text() const { return st_.txt; }
+
+        ParseStats const & stats() const { return st_.stats; }
+
     private:
         details::ParserState st_;
     };
 
+    template<class T>
+    class lazy_object;
+
     template<class T>
     struct TypedParser
     {
-        typedef std::unique_ptr<T>              TPtr;
-        typedef std::function<TPtr (Parser &)>  Factory;
+        typedef std::unique_ptr<T>                              TPtr;
+        typedef std::function<TPtr (Parser &)>                  Factory;
+        typedef pooled_ptr<T>                                   PooledPtr;
+        typedef std::function<PooledPtr (Parser &, ParseContext &)> PooledFactory;
 
         TPtr parse_single(utf8_text const & txt)
+        {
+            return parse_single(txt, stats_);
+        }
+
+        // Doesn't modify the parser, so may be called from several threads at once.
+        TPtr parse_single(utf8_text const & txt, ParseStats & stats) const
         {
             Parser parser(txt);
+            stats_guard sg(parser, stats);
 
-            auto res = parse_single_impl(parser);
-            if (!parser.eot())
-                throw ParseError();
+            auto res = parse_single_impl<TPtr>(parser, make_plain());
+            parser.expect_eot();
 
             return res;
         }
 
+        // Objects of types with pooled factories are placed into the context,
+        // the other ones are allocated as usual.
+        PooledPtr parse_single(utf8_text const & txt, ParseContext & ctx, ParseStats & stats) const
+        {
+            Parser parser(txt);
+            stats_guard sg(parser, stats);
+
+            auto res = parse_single_impl<PooledPtr>(parser, make_pooled(ctx));
+            parser.expect_eot();
+
+            return res;
+        }
+
+        PooledPtr parse_single(utf8_text const & txt, ParseContext & ctx)
+        {
+            return parse_single(txt, ctx, stats_);
+        }
+
         void parse_array(utf8_text const & txt, std::function<void (TPtr)> proc)
+        {
+            parse_array_impl<TPtr>(txt, make_plain(), proc);
+        }
+
+        void parse_array(utf8_text const & txt, ParseContext & ctx, std::function<void (PooledPtr)> proc)
+        {
+            parse_array_impl<PooledPtr>(txt, make_pooled(ctx), proc);
+        }
+
+        // Resolves the type, but leaves the description unparsed until the
+        // object is accessed (jco/lazy.h). The object refers to the text and
+        // to the type name and factory registered in this TypedParser, both
+        // have to outlive it; registering more factories doesn't move them.
+        lazy_object<T> parse_lazy_single(utf8_text const & txt, ParseStats & stats) const
+        {
+            Parser parser(txt);
+            stats_guard sg(parser, stats);
+
+            auto res = parse_single_impl<lazy_object<T>>(parser, make_lazy());
+            parser.expect_eot();
+
+            return res;
+        }
+
+        lazy_object<T> parse_lazy_single(utf8_text const & txt)
+        {
+            return parse_lazy_single(txt, stats_);
+        }
+
+        void parse_lazy_array(utf8_text const & txt, std::function<void (lazy_object<T>)> proc)
+        {
+            parse_array_impl<lazy_object<T>>(txt, make_lazy(), proc);
+        }
+
+        // An element of an array read by other means, e.g. jco::ArrayCursor.
+        TPtr parse_element(Parser & parser) const
+        {
+            return parse_single_impl<TPtr>(parser, make_plain());
+        }
+
+        PooledPtr parse_element(Parser & parser, ParseContext & ctx) const
+        {
+            return parse_single_impl<PooledPtr>(parser, make_pooled(ctx));
+        }
+
+        // statistics of the last parse_single or parse_array call
+        ParseStats const & stats() const { return stats_; }
+
+        void register_factory(std::string const & type, Factory factory)
+        {
+            auto & f = factories_[type];
+            assert(!f.plain);
+            f.plain = std::move(factory);
+        }
+
+        // A type may have both kinds of factories, parsing with a context
+        // prefers the pooled one.
+        void register_pooled_factory(std::string const & type, PooledFactory factory)
+        {
+            auto & f = factories_[type];
+            assert(!f.pooled);
+            f.pooled = std::move(factory);
+        }
+
+    private:
+        struct factories
+        {
+            Factory         plain;
+            PooledFactory   pooled;
+        };
+
+        typedef typename std::map<std::string, factories>::value_type registered;
+
+        struct make_plain
+        {
+            TPtr operator() (registered const & r, Parser & parser) const
+            {
+                auto const & f = r.second;
+                if (!f.plain)
+                    throw std::logic_error("type has only a pooled factory, parse it with a context");
+                return f.plain(parser);
+            }
+        };
+
+        struct make_pooled
+        {
+            explicit make_pooled(ParseContext & ctx)
+                : ctx(ctx)
+            {}
+
+            PooledPtr operator() (registered const & r, Parser & parser) const
+            {
+                auto const & f = r.second;
+                if (f.pooled)
+                    return f.pooled(parser, ctx);
+                // a deleter without a slab deletes the object
+                return PooledPtr(f.plain(parser).release());
+            }
+
+            ParseContext & ctx;
+        };
+
+        struct make_lazy
+        {
+            lazy_object<T> operator() (registered const & r, Parser & parser) const
+            {
+                return lazy_object<T>(parser.text(), parser.raw_value(), r.first, r.second.plain);
+            }
+        };
+
+        template<class Ptr, class Make>
+        void parse_array_impl(utf8_text const & txt, Make const & make, std::function<void (Ptr)> const & proc)
         {
             using details::Token;
 
             Parser parser(txt);
+            stats_guard sg(parser, stats_);
 
             parser.expect(Token::ArrBegin);
             if (parser.next_token() != Token::ArrEnd)
             {
-                proc(parse_single_impl(parser, true));
+                proc(parse_single_impl<Ptr>(parser, make, true));
                 for (;;)
                 {
-                    switch (parser.next_token())
+                    auto token = parser.next_token();
+                    switch (token)
                     {
                     case Token::ArrEnd:
                         return;
                     case Token::Comma:
-                        proc(parse_single_impl(parser));
+                        proc(parse_single_impl<Ptr>(parser, make));
                         break;
+                    case Token::EOT:
+                        details::throw_error(ParseStatus(ParseErrorCode::UnexpectedEnd, parser.position()));
                     default:
-                        throw ParseError();
+                        // the token is a single symbol, as in details::unexpected
+                        details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, parser.position() - 1));
                     }
                 }
             }
         }
 
-        void register_factory(std::string const & type, Factory factory)
-        {
-            assert(!factories_.count(type));
-            factories_[type] = std::move(factory);
-        }
-
-    private:
-        TPtr parse_single_impl(Parser & parser, bool obj_started = false)
+        // Keys of the envelope may come in any order, other keys are skipped.
+        // A description before the type is skipped and parsed in place once
+        // the type is known.
+        template<class Ptr, class Make>
+        Ptr parse_single_impl(Parser & parser, Make const & make, bool obj_started = false) const
         {
             using details::Token;
 
+            auto begin = parser.position();
             if (!obj_started)
                 parser.expect(Token::ObjBegin);
 
-            parser.expect("type");
-            parser.expect(Token::Colon);
-
-            auto type = parser.parse_string();
+            registered const * factory = nullptr;
+            Ptr res;
+            bool has_description = false;
+            std::size_t description = 0;
 
-            if (auto f = find_factory(type))
+            for (;;)
             {
-                parser.expect(Token::Comma);
-                parser.expect("description");
+                auto key_begin = parser.position();
+                auto key = parser.parse_string();
                 parser.expect(Token::Colon);
-                auto res = (*f)(parser);
-                parser.expect(Token::ObjEnd);
-                return res;
+
+                if (key == "type")
+                {
+                    if (factory)
+                        details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, key_begin));
+
+                    auto type = parser.parse_string();
+                    factory = find_factory(type);
+                    if (!factory)
+                        throw std::logic_error("unknown type \"" + type + "\"");
+
+                    if (has_description)
+                    {
+                        auto next = parser.position();
+                        parser.seek(description);
+                        res = make(*factory, parser);
+                        parser.seek(next);
+                    }
+                }
+                else if (key == "description")
+                {
+                    if (has_description)
+                        details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, key_begin));
+
+                    has_description = true;
+                    if (factory)
+                    {
+                        res = make(*factory, parser);
+                    }
+                    else
+                    {
+                        description = parser.position();
+                        parser.skip_value();
+                    }
+                }
+                else
+                {
+                    parser.skip_value();
+                }
+
+                auto separator = parser.position();
+                auto token = parser.next_token();
+                if (token == Token::ObjEnd)
+                    break;
+                if (token != Token::Comma)
+                    details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, separator));
             }
-            else
-                throw std::logic_error("unknown type \"" + type + "\"");
+
+            if (!factory)
+                throw MissingFieldError("type", begin);
+            if (!has_description)
+                throw MissingFieldError("description", begin);
+            return res;
         }
 
     private:
-        Factory const * find_factory(std::string const & type) const
+        registered const * find_factory(std::string const & type) const
         {
             auto it = factories_.find(type);
             if (it == factories_.end())
                 return nullptr;
             else
-                return &it->second;
+                return &*it;
         }
 
     private:
-        std::map<std::string, Factory> factories_;
+        // copies statistics out of the parser also when parsing fails
+        struct stats_guard
+        {
+            stats_guard(Parser const & parser, ParseStats & stats)
+                : parser_(parser)
+                , stats_(stats)
+            {}
+
+            ~stats_guard()
+            {
+                stats_ = parser_.stats();
+            }
+
+        private:
+            Parser const & parser_;
+            ParseStats & stats_;
+        };
+
+    private:
+        std::map<std::string, factories> factories_;
+        ParseStats stats_;
     };
 
+    // Doesn't throw on malformed input, the status tells what went wrong and where.
+    template<typename Res>
+    ParseStatus try_parse_into(utf8_text const & txt, Res & res, ParseOptions const & options = ParseOptions())
+    {
+        details::ParserState st(txt, 0, options);
+        details::skip_BOM(st);
+        if (details::parse(st, res))
+            details::expect_eot(st);
+        return st.status;
+    }
+
+    template<typename Res>
+    struct ParseResult
+    {
+        explicit operator bool() const { return bool(status); }
+
+        Res &       operator * ()       { return value; }
+        Res const & operator * () const { return value; }
+
+        Res *       operator -> ()       { return &value; }
+        Res const * operator -> () const { return &value; }
+
+        Res         value;
+        ParseStatus status;
+    };
+
+    template<typename Res>
+    ParseResult<Res> try_parse(utf8_text const & txt, ParseOptions const & options = ParseOptions())
+    {
+        ParseResult<Res> res;
+        res.status = try_parse_into(txt, res.value, options);
+        return res;
+    }
+
+    // Parses over an existing object: strings and vectors keep their capacity,
+    // so parsing documents of the same shape in a loop doesn't allocate.
+    template<typename Res>
+    void parse_into(utf8_text const & txt, Res & res, ParseOptions const & options = ParseOptions())
+    {
+        auto status = try_parse_into(txt, res, options);
+        if (!status)
+            details::throw_error(status);
+    }
+
     template<typename Res>
     Res parse(utf8_text const & txt)
+    {
+        Res res;
+        parse_into(txt, res);
+        return res;
+    }
+
+    template<typename Res>
+    Res parse(utf8_text const & txt, ParseOptions const & options)
+    {
+        Res res;
+        parse_into(txt, res, options);
+        return res;
+    }
+
+    template<typename Res>
+    Res parse(utf8_text const & txt, ParseStats & stats)
     {
         Parser parser(txt);
         Res res = parser.parse<Res>();
-        if (!parser.eot())
-            throw ParseError();
+        stats = parser.stats();
+        parser.expect_eot();
         return res;
     }
 
@@ -185,16 +650,60 @@ namespace jco
 
         Token next_token(ParserState &);
 
+        bool end_of_text(ParserState const &);
+
+        // throws on errors
         std::string read_string(ParserState &);
 
-        void skip_number(ParserState &);
+        // reuses the capacity of the string
+        bool read_string(ParserState &, std::string & out);
+
+        typedef std::function<void (boost::string_ref)> chunk_sink;
 
-        void read_number(ParserState &, double & out);
+        // Decodes a string into a buffer of chunk_size bytes (at least 8)
+        // handed to sink whenever it's full, size is the length of the whole
+        // string. The sink may read other strings the same way.
+        bool read_string_chunks(ParserState &, std::size_t chunk_size, chunk_sink const & sink, std::size_t & size);
+
+        bool skip_number(ParserState &);
+
+        bool read_number(ParserState &, double & out);
+
+        // Reads an integer without a fraction or an exponent, fails with
+        // NumberOutOfRange if its magnitude doesn't fit 64 bits.
+        bool read_integer(ParserState &, bool & negative, std::uint64_t & magnitude);
+
+        // Number of elements of a flat array, the state is right after its
+        // opening bracket. Only an estimate to reserve memory with.
+        std::size_t count_elements(ParserState const & st);
+
+        template<class T>
+        struct is_number
+            : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>
+        {};
+
+        // how types without own overloads are parsed and cleared
+        struct object_tag {};       // DEF_OBJECT structures
+        struct enum_tag {};         // DEF_ENUM enums
+        struct integer_tag {};
+        struct floating_tag {};
+
+        template<class T>
+        struct value_category
+        {
+            typedef typename std::conditional<std::is_enum<T>::value, enum_tag,
+                    typename std::conditional<std::is_floating_point<T>::value, floating_tag,
+                    typename std::conditional<is_number<T>::value, integer_tag,
+                    object_tag>::type>::type>::type type;
+        };
 
         template<class T>
         struct expected_token_impl
         {
-            static const Token value = Token::ObjBegin;
+            // DEF_OBJECT structures, DEF_ENUM enums or numbers
+            static const Token value = std::is_enum<T>::value
+                ? Token::Quote
+                : (is_number<T>::value ? Token::Number : Token::ObjBegin);
         };
 
         template<>
@@ -215,126 +724,613 @@ namespace jco
             static const Token value = Token::ArrBegin;
         };
 
+        template<class Element, std::size_t N>
+        struct expected_token_impl<std::array<Element, N>>
+        {
+            static const Token value = Token::ArrBegin;
+        };
+
+        template<unsigned Digits>
+        struct expected_token_impl<decimal<Digits>>
+        {
+            static const Token value = Token::Number;
+        };
+
         template<class T>
         constexpr Token expected_token() { return expected_token_impl<T>::value; }
 
         template<>
-        inline void parse<double>(ParserState & st, double & out)
+        inline bool parse<double>(ParserState & st, double & out)
         {
-            read_number(st, out);
+            return read_number(st, out);
         }
 
         template<>
-        inline void parse<std::string>(ParserState & st, std::string & out)
+        inline bool parse<std::string>(ParserState & st, std::string & out)
+        {
+            return read_string(st, out);
+        }
+
+        template<unsigned Digits>
+        bool parse(ParserState & st, decimal<Digits> & out)
         {
-            out = read_string(st);
+            return read_number(st, out.value);
         }
 
+        // Elements are parsed over the existing ones and the rest are erased,
+        // so a vector keeps its capacity and the capacity of its elements.
         template<class Element>
-        void parse(ParserState & st, std::vector<Element> & out)
+        bool parse_vector(ParserState & st, std::vector<Element> & out, std::false_type /* is_number */)
         {
-            if (next_token(st) != Token::ArrBegin)
-                throw ParseError();
+            auto token = next_token(st);
+            if (token != Token::ArrBegin)
+                return unexpected(st, token);
 
+            depth_guard dg(st);
+
+            std::size_t size = 0;
             for (;;)
             {
-                auto token = next_token(st);
+                token = next_token(st);
                 switch (token)
                 {
                 case Token::ArrEnd:
-                    return;
+                    out.erase(out.begin() + size, out.end());
+                    return true;
                 case Token::EOT:
                 case Token::ObjEnd:
-                    throw ParseError();
+                case Token::Error:
+                    return unexpected(st, token);
                 default:
                     if (token != expected_token<Element>())
-                        throw ParseError();
+                        return unexpected(st, token);
 
                     --st.ptr;
-                    out.push_back(parse<Element>(st));
+                    if (size == out.size())
+                    {
+                        JCO_STATS(st.stats.allocations += (out.size() == out.capacity()));
+                        out.emplace_back();
+                    }
+                    if (!parse(st, out[size++]))
+                        return false;
 
-                    switch (next_token(st))
+                    token = next_token(st);
+                    switch (token)
                     {
                     case Token::ArrEnd:
-                        return;
+                        out.erase(out.begin() + size, out.end());
+                        return true;
                     case Token::Comma:
                         break;
                     default:
-                        throw ParseError();
+                        return unexpected(st, token);
                     }
                 }
             }
         }
 
-        struct value_reader
+        // Arrays of numbers are counted ahead to reserve once, then the numbers
+        // are read one after another without looking at their first symbol twice.
+        template<class Element>
+        bool parse_vector(ParserState & st, std::vector<Element> & out, std::true_type /* is_number */)
+        {
+            auto token = next_token(st);
+            if (token != Token::ArrBegin)
+                return unexpected(st, token);
+
+            depth_guard dg(st);
+
+            if (end_of_text(st) || (skip_spaces(st) == SSStatus::EOT))
+                return fail(st, ParseErrorCode::UnexpectedEnd);
+            if (st.txt.data[st.ptr] == ']')
+            {
+                ++st.ptr;
+                out.clear();
+                return true;
+            }
+
+            auto count = count_elements(st);
+            JCO_STATS(st.stats.allocations += (count > out.capacity()));
+            out.reserve(count);
+
+            std::size_t size = 0;
+            for (;;)
+            {
+                // anything else is reported as a token, e.g. a trailing comma
+                auto c = st.txt.data[st.ptr];
+                if (((c < '0') || (c > '9')) && (c != '-'))
+                    return unexpected(st, next_token(st));
+
+                if (size == out.size())
+                {
+                    JCO_STATS(st.stats.allocations += (out.size() == out.capacity()));
+                    out.emplace_back();
+                }
+                if (!parse(st, out[size++]))
+                    return false;
+
+                token = next_token(st);
+                if (token == Token::ArrEnd)
+                    break;
+                if (token != Token::Comma)
+                    return unexpected(st, token);
+                if (end_of_text(st) || (skip_spaces(st) == SSStatus::EOT))
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
+            }
+
+            out.erase(out.begin() + size, out.end());
+            return true;
+        }
+
+        template<class Element>
+        bool parse(ParserState & st, std::vector<Element> & out)
+        {
+            return parse_vector(st, out, is_number<Element>());
+        }
+
+        // exactly N elements
+        template<class Element, std::size_t N>
+        bool parse(ParserState & st, std::array<Element, N> & out)
+        {
+            auto token = next_token(st);
+            if (token != Token::ArrBegin)
+                return unexpected(st, token);
+
+            depth_guard dg(st);
+
+            for (std::size_t i = 0; i != N; ++i)
+            {
+                if (i != 0)
+                {
+                    token = next_token(st);
+                    if (token != Token::Comma)
+                        return unexpected(st, token);
+                }
+                if (end_of_text(st) || (skip_spaces(st) == SSStatus::EOT))
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
+                if (!parse(st, out[i]))
+                    return false;
+            }
+
+            token = next_token(st);
+            if (token != Token::ArrEnd)
+                return unexpected(st, token);
+            return true;
+        }
+
+        // Resets a value keeping its capacity, applied to the fields missing in the input.
+        template<class T>
+        void clear(T & value);
+
+        template<class Element>
+        void clear(std::vector<Element> & value);
+
+        template<class Element, std::size_t N>
+        void clear(std::array<Element, N> & value);
+
+        template<unsigned Digits>
+        void clear(decimal<Digits> & value);
+
+        template<class... Types>
+        void clear(boost::variant<Types...> & value);
+
+        template<class Value>
+        void clear(std::map<std::string, Value> & value);
+
+        template<class Value>
+        void clear(std::unordered_map<std::string, Value> & value);
+
+        template<class Value>
+        void clear(flat_map<Value> & value);
+
+        struct field_clearer
         {
             template<typename Field>
-            void operator() (Field & f, const char * key)
+            void operator() (Field & f, const char *)
             {
-                if (key_was_found_)
-                    return;
-                else if (key_was_found_ = (key_ == key))
-                    parse(st_, f);
+                clear(f);
             }
+        };
+
+        template<class T>
+        void clear_object(T & value, std::false_type /* by table */)
+        {
+            for_each(value, field_clearer());
+        }
+
+        template<class T>
+        void clear_object(T & value, std::true_type /* by table */);
+
+        template<class T>
+        void clear_impl(T & value, object_tag)
+        {
+            typedef std::integral_constant<bool, decode_by_table(static_cast<T const *>(nullptr))> by_table;
+            clear_object(value, by_table());
+        }
+
+        // enums and numbers
+        template<class T, class Category>
+        void clear_impl(T & value, Category)
+        {
+            value = T();
+        }
+
+        template<class T>
+        void clear(T & value)
+        {
+            clear_impl(value, typename value_category<T>::type());
+        }
+
+        template<>
+        inline void clear<double>(double & value)
+        {
+            value = 0;
+        }
+
+        template<>
+        inline void clear<std::string>(std::string & value)
+        {
+            value.clear();
+        }
+
+        template<class Element>
+        void clear(std::vector<Element> & value)
+        {
+            value.clear();
+        }
+
+        template<class Element, std::size_t N>
+        void clear(std::array<Element, N> & value)
+        {
+            for (auto & e : value)
+                clear(e);
+        }
+
+        template<unsigned Digits>
+        void clear(decimal<Digits> & value)
+        {
+            value.value = 0;
+        }
+
+        template<class Value>
+        void clear(std::map<std::string, Value> & value)
+        {
+            value.clear();
+        }
 
-            value_reader(boost::string_ref key, ParserState & st, bool & key_was_found)
-                : key_(key)
-                , st_(st)
-                , key_was_found_(key_was_found)
+        template<class Value>
+        void clear(std::unordered_map<std::string, Value> & value)
+        {
+            value.clear();
+        }
+
+        template<class Value>
+        void clear(flat_map<Value> & value)
+        {
+            value.clear();
+        }
+
+        bool skip_value(ParserState &);
+
+        // Reads a string without copying it: strings without escape sequences
+        // point into the text, others are decoded into the buffer.
+        bool read_string_ref(ParserState &, std::string & buffer, boost::string_ref & str);
+
+        // index of the name equal to the key, count if there is none
+        std::size_t find_field(boost::string_ref const * names, std::size_t count, boost::string_ref key);
+
+        struct field_parser
+        {
+            field_parser(ParserState & st, bool & ok)
+                : st_(st)
+                , ok_(ok)
+            {}
+
+            template<typename Field>
+            void operator() (Field & f, const char *)
             {
-                key_was_found = false;
+                ok_ = parse(st_, f);
             }
 
         private:
-            boost::string_ref key_;
             ParserState & st_;
-            bool & key_was_found_;
+            bool & ok_;
         };
 
-        void skip_value(ParserState &);
+        // Moves over the pattern if the text continues with it.
+        template<std::size_t N>
+        bool skip_pattern(ParserState & st, const char (&pattern)[N])
+        {
+            if ((st.txt.size - st.ptr < N - 1) || (std::memcmp(st.txt.data + st.ptr, pattern, N - 1) != 0))
+                return false;
+            st.ptr += N - 1;
+            return true;
+        }
+
+        // Reads an object calling member(key) with the state at the value of
+        // every member, member has to read the value. Trusted input in the
+        // single line style goes from a value to the next key without tokens.
+        template<class F>
+        bool parse_members(ParserState & st, F member)
+        {
+            auto token = next_token(st);
+            if (token != Token::ObjBegin)
+                return unexpected(st, token);
+
+            depth_guard dg(st);
+            std::string key_buffer;
+
+            token = next_token(st);
+            if (token == Token::ObjEnd)
+                return true;
+
+            for (;;)
+            {
+                if (token != Token::Quote)
+                    return unexpected(st, token);
+
+                --st.ptr;
+                boost::string_ref key;
+                if (!read_string_ref(st, key_buffer, key))
+                    return false;
+                if (!st.options.trusted || !skip_pattern(st, " : "))
+                {
+                    token = next_token(st);
+                    if (token != Token::Colon)
+                        return unexpected(st, token);
+                    if (end_of_text(st) || (skip_spaces(st) == SSStatus::EOT))
+                        return fail(st, ParseErrorCode::UnexpectedEnd);
+                }
+
+                if (!member(key))
+                    return false;
+
+                if (st.options.trusted)
+                {
+                    if (skip_pattern(st, ", \""))
+                    {
+                        token = Token::Quote;
+                        continue;
+                    }
+                    if (skip_pattern(st, " }"))
+                        return true;
+                }
+
+                token = next_token(st);
+                if (token == Token::ObjEnd)
+                    return true;
+                if (token != Token::Comma)
+                    return unexpected(st, token);
+                token = next_token(st);
+            }
+        }
+
+        // objects with arbitrary keys, the last of equal keys wins
+
+        template<class Value>
+        bool parse(ParserState & st, std::map<std::string, Value> & out)
+        {
+            out.clear();
+            return parse_members(st, [&] (boost::string_ref key) {
+                return parse(st, out[key.to_string()]);
+            });
+        }
+
+        template<class Value>
+        bool parse(ParserState & st, std::unordered_map<std::string, Value> & out)
+        {
+            out.clear();
+            return parse_members(st, [&] (boost::string_ref key) {
+                return parse(st, out[key.to_string()]);
+            });
+        }
+
+        // Pairs are parsed over the existing ones, as elements of vectors,
+        // and sorted once at the end. Members aren't counted ahead, that
+        // would scan their values twice.
+        template<class Value>
+        bool parse(ParserState & st, flat_map<Value> & out)
+        {
+            auto & items = out.items();
+
+            std::size_t size = 0;
+            bool ok = parse_members(st, [&] (boost::string_ref key) {
+                if (size == items.size())
+                {
+                    JCO_STATS(st.stats.allocations += (items.size() == items.capacity()));
+                    items.emplace_back();
+                }
+                auto & item = items[size++];
+                item.first.assign(key.data(), key.size());
+                return parse(st, item.second);
+            });
+
+            items.erase(items.begin() + size, items.end());
+            out.sort();
+            return ok;
+        }
+
+        // Table-driven decoding: DEF_OBJECT emits a table of the fields with
+        // their offsets, and objects of all the types decoded by table share a
+        // single non-template decoder. Values of common types are read by the
+        // decoder itself, the rest through type-erased functions.
+
+        enum class field_type : unsigned char
+        {
+            Double, Float, Int32, Int64, UInt32, UInt64, String, Other
+        };
+
+        template<class T> struct field_type_of          : std::integral_constant<field_type, field_type::Other> {};
+        template<> struct field_type_of<double>         : std::integral_constant<field_type, field_type::Double> {};
+        template<> struct field_type_of<float>          : std::integral_constant<field_type, field_type::Float> {};
+        template<> struct field_type_of<std::int32_t>   : std::integral_constant<field_type, field_type::Int32> {};
+        template<> struct field_type_of<std::int64_t>   : std::integral_constant<field_type, field_type::Int64> {};
+        template<> struct field_type_of<std::uint32_t>  : std::integral_constant<field_type, field_type::UInt32> {};
+        template<> struct field_type_of<std::uint64_t>  : std::integral_constant<field_type, field_type::UInt64> {};
+        template<> struct field_type_of<std::string>    : std::integral_constant<field_type, field_type::String> {};
+
+        struct field_ops
+        {
+            bool (*parse)(ParserState &, void *);
+            void (*clear)(void *);
+        };
+
+        template<class T>
+        bool parse_erased(ParserState & st, void * value)
+        {
+            return parse(st, *static_cast<T *>(value));
+        }
+
+        template<class T>
+        void clear_erased(void * value)
+        {
+            clear(*static_cast<T *>(value));
+        }
+
+        template<class T>
+        struct field_ops_of
+        {
+            static const field_ops value;
+        };
+
+        template<class T>
+        const field_ops field_ops_of<T>::value = { &parse_erased<T>, &clear_erased<T> };
+
+        struct field_descriptor
+        {
+            boost::string_ref   name;
+            std::size_t         offset;
+            field_type          type;
+            field_ops const *   ops;
+        };
+
+        bool parse_fields(ParserState & st, void * object, field_descriptor const * fields, std::size_t count);
+
+        void clear_fields(void * object, field_descriptor const * fields, std::size_t count);
+
+        template<class T>
+        void clear_object(T & value, std::true_type /* by table */)
+        {
+            auto self = static_cast<T const *>(nullptr);
+            clear_fields(&value, field_table(self), fields_count(self));
+        }
 
         template<class Res>
-        void read_key_value_pair(ParserState & st, Res & res)
+        bool parse_object(ParserState & st, Res & res, std::true_type /* by table */)
         {
-            std::string key = read_string(st);
-            if (next_token(st) != Token::Colon)
-                throw ParseError();
-            skip_spaces(st);
-            bool key_was_found;
-            for_each(res, value_reader(key, st, key_was_found));
-            if (!key_was_found)
-                skip_value(st);
+            auto self = static_cast<Res const *>(nullptr);
+            return parse_fields(st, &res, field_table(self), fields_count(self));
         }
 
         template<class Res>
-        void parse(ParserState & st, Res & res)
+        bool parse_object(ParserState & st, Res & res, std::false_type /* by table */)
         {
-            if (next_token(st) != Token::ObjBegin)
-                throw ParseError();
+            constexpr std::size_t fields_num = fields_count(static_cast<Res const *>(nullptr));
+            auto names = field_names(static_cast<Res const *>(nullptr));
 
-            for (;;)
+            std::bitset<fields_num> seen;
+            // documents are usually written with the same description,
+            // so the field after the last matched one is tried first
+            std::size_t expected = 0;
+
+            bool ok = parse_members(st, [&] (boost::string_ref key) {
+                auto index = ((expected < fields_num) && (names[expected] == key))
+                    ? expected
+                    : find_field(names, fields_num, key);
+                if (index == fields_num)
+                {
+                    JCO_STATS(++st.stats.unmatched_keys);
+                    return skip_value(st);
+                }
+
+                bool parsed = false;
+                visit_field(res, index, field_parser(st, parsed));
+                seen.set(index);
+                expected = index + 1;
+                return parsed;
+            });
+            if (!ok)
+                return false;
+
+            if (!seen.all())
             {
-                switch (next_token(st))
+                for (std::size_t i = 0; i != fields_num; ++i)
                 {
-                case Token::ObjEnd:
-                    return;
-                case Token::Quote:
-                    --st.ptr;
-                    read_key_value_pair(st, res);
-                    switch (next_token(st))
+                    if (seen.test(i))
+                        continue;
+                    if (st.options.require_all_fields)
                     {
-                    case Token::ObjEnd:
-                        return;
-                    case Token::Comma:
-                        break;
-                    default:
-                        throw ParseError();
+                        st.status.field = names[i];
+                        return fail(st, ParseErrorCode::MissingField);
                     }
-                    break;
-                default:
-                    throw ParseError();
+                    visit_field(res, i, field_clearer());
                 }
             }
+            return true;
+        }
+
+        template<class Res>
+        bool parse_impl(ParserState & st, Res & res, object_tag)
+        {
+            typedef std::integral_constant<bool, decode_by_table(static_cast<Res const *>(nullptr))> by_table;
+            return parse_object(st, res, by_table());
+        }
+
+        template<class Res>
+        bool parse_impl(ParserState & st, Res & res, enum_tag)
+        {
+            thread_local std::string buffer;
+
+            auto begin = st.ptr;
+            boost::string_ref str;
+            if (!read_string_ref(st, buffer, str))
+                return false;
+            if (!enum_from_string(str, res))
+                return fail(st, ParseErrorCode::UnknownEnumValue, begin);
+            return true;
+        }
+
+        template<class Res>
+        bool parse_impl(ParserState & st, Res & res, integer_tag)
+        {
+            typedef std::numeric_limits<Res> limits;
+
+            auto begin = st.ptr;
+            bool negative;
+            std::uint64_t magnitude;
+            if (!read_integer(st, negative, magnitude))
+                return false;
+
+            if (!negative || (magnitude == 0))
+            {
+                if (magnitude > static_cast<std::uint64_t>(limits::max()))
+                    return fail(st, ParseErrorCode::NumberOutOfRange, begin);
+                res = static_cast<Res>(magnitude);
+            }
+            else
+            {
+                // -magnitude without overflowing on the minimum
+                if (!limits::is_signed || (magnitude - 1 > static_cast<std::uint64_t>(limits::max())))
+                    return fail(st, ParseErrorCode::NumberOutOfRange, begin);
+                res = static_cast<Res>(-static_cast<long long>(magnitude - 1) - 1);
+            }
+            return true;
+        }
+
+        template<class Res>
+        bool parse_impl(ParserState & st, Res & res, floating_tag)
+        {
+            double x;
+            if (!read_number(st, x))
+                return false;
+            res = static_cast<Res>(x);
+            return true;
+        }
+
+        template<class Res>
+        bool parse(ParserState & st, Res & res)
+        {
+            return parse_impl(st, res, typename value_category<Res>::type());
         }
     }
 }
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <typeindex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jco
+{
+    namespace details
+    {
+        // Storage for objects of a single size: slots are cut from blocks
+        // of growing size, released slots are reused first.
+        class slab
+        {
+        public:
+            slab(std::size_t size, std::size_t align);
+            ~slab();
+
+            slab(slab const &) = delete;
+            slab& operator = (slab const &) = delete;
+
+            void * allocate();
+            void release(void * slot);
+
+            // slots given out and not released yet
+            std::size_t used() const { return used_; }
+
+        private:
+            struct free_slot
+            {
+                free_slot * next;
+            };
+
+            std::size_t         slot_size_;
+            std::size_t         block_slots_;
+            std::vector<void *> blocks_;
+            char *              next_   = nullptr;
+            char *              end_    = nullptr;
+            free_slot *         free_   = nullptr;
+            std::size_t         used_   = 0;
+        };
+    }
+
+    // Deleter of objects made by ParseContext, destroys the object and gives
+    // its slot back to the slab. Without a slab the object is deleted.
+    // Converts to the deleter of a base only if the base has a virtual
+    // destructor, the object is destroyed through a pointer to the base.
+    template<class T>
+    class pool_deleter
+    {
+    public:
+        pool_deleter()
+            : slab_(nullptr)
+            , slot_(nullptr)
+        {}
+
+        pool_deleter(details::slab * slab, void * slot)
+            : slab_(slab)
+            , slot_(slot)
+        {}
+
+        template<class U>
+        pool_deleter(pool_deleter<U> const & other)
+            : slab_(other.slab_)
+            , slot_(other.slot_)
+        {
+            static_assert(std::is_same<T, U>::value || std::has_virtual_destructor<T>::value,
+                          "objects are destroyed through a base without a virtual destructor");
+        }
+
+        void operator() (T * p) const
+        {
+            if (!slab_)
+            {
+                delete p;
+                return;
+            }
+            // slot_ is the address of the whole object, p may point to its base
+            p->~T();
+            slab_->release(slot_);
+        }
+
+    private:
+        template<class U>
+        friend class pool_deleter;
+
+        details::slab * slab_;
+        void *          slot_;
+    };
+
+    // Owning pointer to an object in a ParseContext. Pointers to derived
+    // types convert to pointers to their bases, as std::unique_ptr.
+    template<class T>
+    using pooled_ptr = std::unique_ptr<T, pool_deleter<T>>;
+
+    // Per-type pools for objects created while parsing: objects of a type are
+    // placed next to each other in memory and allocation is a pop from a free
+    // list or a bump of a pointer. All the objects have to be released before
+    // the context is destroyed, its memory is then freed in bulk; destroying
+    // a context with objects still alive terminates the program, their
+    // handles would release slots of freed memory.
+    // Isn't thread safe, use a context per thread.
+    class ParseContext
+    {
+    public:
+        ParseContext();
+        ~ParseContext();
+
+        ParseContext(ParseContext const &) = delete;
+        ParseContext& operator = (ParseContext const &) = delete;
+
+        template<class T, class... Args>
+        pooled_ptr<T> make(Args &&... args)
+        {
+            static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types aren't supported");
+
+            auto & pool = slab_for(typeid(T), sizeof(T), alignof(T));
+            void * slot = pool.allocate();
+            try
+            {
+                return pooled_ptr<T>(new (slot) T(std::forward<Args>(args)...), pool_deleter<T>(&pool, slot));
+            }
+            catch (...)
+            {
+                pool.release(slot);
+                throw;
+            }
+        }
+
+        // objects alive in the context
+        std::size_t used() const;
+
+    private:
+        details::slab & slab_for(std::type_index type, std::size_t size, std::size_t align);
+
+    private:
+        std::unordered_map<std::type_index, std::unique_ptr<details::slab>> slabs_;
+        // the last type asked for, usually the same as the next one
+        std::type_index     last_type_;
+        details::slab *     last_slab_;
+    };
+}
@@ -1,12 +1,24 @@
 #pragma once
 
+#include <array>
 #include <ostream>
 #include <sstream>
 #include <memory>
+#include <iterator>
+#include <functional>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <type_traits>
 
 #include <boost/utility/string_ref.hpp>
 #include <boost/preprocessor/cat.hpp>
 
+#include "stats.h"
+#include "flat_map.h"
+#include "decimal.h"
+
 namespace jco
 {
     struct SerializationError : std::exception {};
@@ -74,8 +86,43 @@ namespace jco
 
         typedef value_tag<boost::string_ref>    string_value_tag;
         typedef value_tag<double>               number_value_tag;
+        typedef value_tag<long long>            integer_value_tag;
+        typedef value_tag<unsigned long long>   unsigned_value_tag;
         typedef value_tag<bool>                 bool_value_tag;
 
+        // a number written with the given count of digits after the point
+        struct fixed_tag
+        {
+            double      value;
+            unsigned    digits;
+        };
+
+        inline fixed_tag fixed(double x, unsigned digits) { return { x, digits }; }
+
+        typedef value_tag<fixed_tag>            fixed_value_tag;
+
+        // bytes written as a base64 string, see also jco::binary
+        struct base64_tag
+        {
+            const void *    data;
+            std::size_t     size;
+        };
+
+        inline base64_tag base64(const void * data, std::size_t size) { return { data, size }; }
+
+        typedef value_tag<base64_tag>           base64_value_tag;
+
+        // an already serialized value written as is, e.g. a part of a parsed
+        // document forwarded without parsing it, isn't validated
+        struct raw_tag
+        {
+            boost::string_ref text;
+        };
+
+        inline raw_tag raw(boost::string_ref text) { return { text }; }
+
+        typedef value_tag<raw_tag>              raw_value_tag;
+
         template<class Value>
         value_tag<Value> value(Value v) { return { v }; }
 
@@ -107,6 +154,11 @@ namespace jco
             out_stream& operator << (boost::string_ref str);
             out_stream& operator << (char const * str);
             out_stream& operator << (double x);
+            out_stream& operator << (long long x);
+            out_stream& operator << (unsigned long long x);
+            out_stream& operator << (fixed_tag x);
+            out_stream& operator << (base64_tag x);
+            out_stream& operator << (raw_tag x);
             out_stream& operator << (bool f);
             out_stream& operator << (std::nullptr_t);
 
@@ -117,12 +169,31 @@ namespace jco
 
             out_stream& operator << (string_value_tag);
             out_stream& operator << (number_value_tag);
+            out_stream& operator << (integer_value_tag);
+            out_stream& operator << (unsigned_value_tag);
+            out_stream& operator << (fixed_value_tag);
+            out_stream& operator << (base64_value_tag);
+            out_stream& operator << (raw_value_tag);
             out_stream& operator << (bool_value_tag);
             out_stream& operator << (null_value_tag);
 
             out_stream(std::ostream & backend, Style style);
             ~out_stream();
 
+            SerializationStats const & stats() const;
+
+            // Starts the next top level value, e.g. to write a sequence of
+            // documents with a single stream. A partially written value is
+            // abandoned, its text stays in the backend.
+            void reset();
+
+            // Writes an array of count elements, splitting them into chunks which
+            // are serialized concurrently into separate buffers by serialize_chunk
+            // (called with a stream and a half-open range of indices). Used by
+            // operator << for parallel_tag.
+            typedef std::function<void (out_stream &, std::size_t, std::size_t)> ChunkSerializer;
+            void write_parallel(std::size_t count, std::size_t threads, ChunkSerializer const & serialize_chunk);
+
         private:
 
             friend struct array_scope;
@@ -227,6 +298,200 @@ namespace jco
             return out;
         }
 
+        namespace details
+        {
+            // How a value of a DEF_OBJECT field is written: after a key
+            // (field) or as an array element or a whole document (element).
+            // The primary template handles DEF_OBJECT structures themselves.
+            template<class T, class Enable = void>
+            struct value_writer
+            {
+                static void field(out_stream & out, T const & obj);
+                static void element(out_stream & out, T const & obj);
+            };
+
+            struct field_writer
+            {
+                template<class Field>
+                void operator() (Field const & f, const char * name)
+                {
+                    out_ << key(name);
+                    value_writer<Field>::field(out_, f);
+                }
+
+                explicit field_writer(out_stream & out)
+                    : out_(out)
+                {}
+
+            private:
+                out_stream & out_;
+            };
+
+            template<class T, class Enable>
+            void value_writer<T, Enable>::field(out_stream & out, T const & obj)
+            {
+                out << value(object);
+                element(out, obj);
+            }
+
+            template<class T, class Enable>
+            void value_writer<T, Enable>::element(out_stream & out, T const & obj)
+            {
+                object_scope os(out);
+                for_each(obj, field_writer(out));
+            }
+
+            template<>
+            struct value_writer<double>
+            {
+                static void field(out_stream & out, double x)   { out << value(x); }
+                static void element(out_stream & out, double x) { out << x; }
+            };
+
+            // integers are written exactly, as long long or unsigned long long
+            template<class T>
+            struct value_writer<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type>
+            {
+                typedef typename std::conditional<std::is_signed<T>::value, long long, unsigned long long>::type wide_t;
+
+                static void field(out_stream & out, T x)    { out << value(static_cast<wide_t>(x)); }
+                static void element(out_stream & out, T x)  { out << static_cast<wide_t>(x); }
+            };
+
+            template<>
+            struct value_writer<float>
+            {
+                static void field(out_stream & out, float x)    { out << value(static_cast<double>(x)); }
+                static void element(out_stream & out, float x)  { out << static_cast<double>(x); }
+            };
+
+            template<unsigned Digits>
+            struct value_writer<decimal<Digits>>
+            {
+                static void field(out_stream & out, decimal<Digits> x)      { out << value(fixed(x.value, Digits)); }
+                static void element(out_stream & out, decimal<Digits> x)    { out << fixed(x.value, Digits); }
+            };
+
+            template<>
+            struct value_writer<std::string>
+            {
+                static void field(out_stream & out, std::string const & s)      { out << value(s); }
+                static void element(out_stream & out, std::string const & s)    { out << boost::string_ref(s); }
+            };
+
+            // DEF_ENUM enums
+            template<class T>
+            struct value_writer<T, typename std::enable_if<std::is_enum<T>::value>::type>
+            {
+                static void field(out_stream & out, T x)    { out << value(enum_to_string(x)); }
+                static void element(out_stream & out, T x)  { out << enum_to_string(x); }
+            };
+
+            template<class Element>
+            struct value_writer<std::vector<Element>>
+            {
+                static void field(out_stream & out, std::vector<Element> const & v)
+                {
+                    out << value(array);
+                    element(out, v);
+                }
+
+                static void element(out_stream & out, std::vector<Element> const & v)
+                {
+                    array_scope as(out);
+                    for (auto const & e : v)
+                        value_writer<Element>::element(out, e);
+                }
+            };
+
+            template<class Element, std::size_t N>
+            struct value_writer<std::array<Element, N>>
+            {
+                static void field(out_stream & out, std::array<Element, N> const & a)
+                {
+                    out << value(array);
+                    element(out, a);
+                }
+
+                static void element(out_stream & out, std::array<Element, N> const & a)
+                {
+                    array_scope as(out);
+                    for (auto const & e : a)
+                        value_writer<Element>::element(out, e);
+                }
+            };
+
+            // objects with arbitrary keys
+            template<class Map>
+            struct map_writer
+            {
+                static void field(out_stream & out, Map const & m)
+                {
+                    out << value(object);
+                    element(out, m);
+                }
+
+                static void element(out_stream & out, Map const & m)
+                {
+                    object_scope os(out);
+                    for (auto const & item : m)
+                    {
+                        typedef typename std::decay<decltype(item.second)>::type value_t;
+                        out << key(item.first);
+                        value_writer<value_t>::field(out, item.second);
+                    }
+                }
+            };
+
+            template<class Value>
+            struct value_writer<std::map<std::string, Value>> : map_writer<std::map<std::string, Value>> {};
+
+            template<class Value>
+            struct value_writer<std::unordered_map<std::string, Value>> : map_writer<std::unordered_map<std::string, Value>> {};
+
+            template<class Value>
+            struct value_writer<flat_map<Value>> : map_writer<flat_map<Value>> {};
+        }
+
+        // Writes a DEF_OBJECT structure, with all the fields supported by the
+        // parser, as a document or an array element.
+        template<class T>
+        out_stream& write(out_stream & out, T const & obj)
+        {
+            details::value_writer<T>::element(out, obj);
+            return out;
+        }
+
+        template<class Range>
+        struct parallel_tag
+        {
+            Range const &   range;
+            std::size_t     threads;
+        };
+
+        // Serializes a range of ISerializable pointers as an array using several
+        // threads, 0 means one per core. The output is the same as for the range
+        // itself, so elements must not depend on each other's serialization.
+        template<class Range>
+        parallel_tag<Range> parallel(Range const & range, std::size_t threads = 0) { return { range, threads }; }
+
+        template<class Range>
+        out_stream& operator << (out_stream & out, parallel_tag<Range> const & p)
+        {
+            static_assert(is_serializable<Range>(), "range of pointers to ISerializable is expected");
+
+            auto begin = std::begin(p.range);
+            auto count = static_cast<std::size_t>(std::distance(begin, std::end(p.range)));
+
+            out.write_parallel(count, p.threads, [begin] (out_stream & chunk_out, std::size_t from, std::size_t to) {
+                auto it = std::next(begin, from);
+                for (auto i = from; i != to; ++i, ++it)
+                    (*it)->serialize(chunk_out);
+            });
+
+            return out;
+        }
+
         template<typename T>
         std::string to_string(T const & t)
         {
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+// Counters are updated on the hot paths of the parser and out_stream, so the
+// updates are compiled in only when JCO_ENABLE_STATS is defined (cmake option
+// of the same name). The structures themselves always exist, without the
+// option they just stay zero.
+#ifdef JCO_ENABLE_STATS
+#   define JCO_STATS(expr) expr
+#else
+#   define JCO_STATS(expr) ((void) 0)
+#endif
+
+namespace jco
+{
+    struct ParseStats
+    {
+        // values of unknown keys (or explicit skip_value calls) and their size
+        std::size_t values_skipped      = 0;
+        std::size_t bytes_skipped       = 0;
+
+        // keys of objects which are not in the DEF_OBJECT description
+        std::size_t unmatched_keys      = 0;
+
+        // strings that contained at least one escape sequence
+        std::size_t unescaped_strings   = 0;
+
+        // growth of strings and vectors created by the parser,
+        // each of them costs a heap allocation
+        std::size_t allocations         = 0;
+
+        // maximal nesting of objects and arrays
+        std::size_t max_depth           = 0;
+    };
+
+    struct SerializationStats
+    {
+        std::size_t values      = 0;
+        std::size_t keys        = 0;
+        std::size_t containers  = 0;
+        std::size_t max_depth   = 0;
+    };
+}
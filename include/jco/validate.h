@@ -0,0 +1,12 @@
+#pragma once
+
+#include "parser.h"
+
+namespace jco
+{
+    // Checks that the text is a single well-formed JSON value (RFC 8259) with
+    // well-formed UTF-8 in strings, without building anything. Stricter than
+    // the parser: leading zeros, trailing commas and raw control symbols in
+    // strings are errors.
+    ParseStatus validate(utf8_text const & txt);
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <boost/variant.hpp>
+
+#include "parser.h"
+#include "serialization.h"
+
+// Heterogeneous arrays with the set of types known at compile time: elements
+// are values of boost::variant stored contiguously, instead of objects behind
+// pointers made by TypedParser. An element is written as
+//
+//     { "type" : <type_name of the alternative>, "description" : <value> }
+//
+// and the keys may come in any order, as for TypedParser. Names of the types
+// are given by DEF_TYPE_NAME.
+
+namespace jco
+{
+    namespace details
+    {
+        template<class Variant, std::size_t Index, class... Types>
+        struct variant_alternatives;
+
+        template<class Variant, std::size_t Index>
+        struct variant_alternatives<Variant, Index>
+        {
+            static std::size_t find(boost::string_ref)
+            {
+                return Index;
+            }
+
+            static bool parse(ParserState &, Variant &, std::size_t)
+            {
+                return false;
+            }
+        };
+
+        template<class Variant, std::size_t Index, class T, class... Rest>
+        struct variant_alternatives<Variant, Index, T, Rest...>
+        {
+            typedef variant_alternatives<Variant, Index + 1, Rest...> next;
+
+            // index of the alternative with the name, the count of them if there is none
+            static std::size_t find(boost::string_ref name)
+            {
+                return (type_name(static_cast<T const *>(nullptr)) == name) ? Index : next::find(name);
+            }
+
+            // parses over the current value if it has the same type
+            static bool parse(ParserState & st, Variant & out, std::size_t index)
+            {
+                if (index != Index)
+                    return next::parse(st, out, index);
+                if (out.which() != static_cast<int>(Index))
+                    out = T();
+                return details::parse(st, boost::get<T>(out));
+            }
+        };
+
+        template<class... Types>
+        struct expected_token_impl<boost::variant<Types...>>
+        {
+            static const Token value = Token::ObjBegin;
+        };
+
+        template<class... Types>
+        bool parse(ParserState & st, boost::variant<Types...> & out)
+        {
+            typedef variant_alternatives<boost::variant<Types...>, 0, Types...> alternatives;
+            const std::size_t unknown = sizeof...(Types);
+
+            std::string buffer;
+            std::size_t index = unknown;
+            bool has_description = false;
+            // where the description is, if it comes before the type
+            std::size_t description = 0;
+
+            bool ok = parse_members(st, [&] (boost::string_ref key) {
+                if (key == "type")
+                {
+                    if (index != unknown)
+                        return fail(st, ParseErrorCode::UnexpectedToken);
+
+                    auto begin = st.ptr;
+                    boost::string_ref name;
+                    if (!read_string_ref(st, buffer, name))
+                        return false;
+                    index = alternatives::find(name);
+                    if (index == unknown)
+                        return fail(st, ParseErrorCode::UnknownType, begin);
+
+                    if (!has_description)
+                        return true;
+
+                    auto next = st.ptr;
+                    st.ptr = description;
+                    if (!alternatives::parse(st, out, index))
+                        return false;
+                    st.ptr = next;
+                    return true;
+                }
+
+                if (key == "description")
+                {
+                    if (has_description)
+                        return fail(st, ParseErrorCode::UnexpectedToken);
+
+                    has_description = true;
+                    if (index != unknown)
+                        return alternatives::parse(st, out, index);
+
+                    description = st.ptr;
+                    return skip_value(st);
+                }
+
+                return skip_value(st);
+            });
+            if (!ok)
+                return false;
+
+            if ((index == unknown) || !has_description)
+            {
+                st.status.field = (index == unknown) ? "type" : "description";
+                return fail(st, ParseErrorCode::MissingField);
+            }
+            return true;
+        }
+
+        template<class... Types>
+        void clear(boost::variant<Types...> & value)
+        {
+            value = boost::variant<Types...>();
+        }
+    }
+
+    namespace serialization
+    {
+        namespace details
+        {
+            template<class... Types>
+            struct value_writer<boost::variant<Types...>>
+            {
+                struct envelope_writer : boost::static_visitor<>
+                {
+                    explicit envelope_writer(out_stream & out)
+                        : out_(out)
+                    {}
+
+                    template<class T>
+                    void operator() (T const & x) const
+                    {
+                        out_ << key("type") << value(type_name(&x));
+                        out_ << key("description");
+                        value_writer<T>::field(out_, x);
+                    }
+
+                private:
+                    out_stream & out_;
+                };
+
+                static void field(out_stream & out, boost::variant<Types...> const & v)
+                {
+                    out << value(object);
+                    element(out, v);
+                }
+
+                static void element(out_stream & out, boost::variant<Types...> const & v)
+                {
+                    object_scope os(out);
+                    boost::apply_visitor(envelope_writer(out), v);
+                }
+            };
+        }
+    }
+}
@@ -0,0 +1,213 @@
+#include "jco/base64.h"
+
+#include <cstring>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace jco
+{
+    namespace
+    {
+        const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        const std::uint8_t invalid = 0xFF;
+
+        // values of the symbols, invalid for the rest
+        struct decode_table
+        {
+            decode_table()
+            {
+                std::memset(values, invalid, sizeof(values));
+                for (std::uint8_t i = 0; i != 64; ++i)
+                    values[static_cast<unsigned char>(alphabet[i])] = i;
+            }
+
+            std::uint8_t values[256];
+        };
+
+        const decode_table table;
+
+        std::uint32_t group(std::uint8_t const * in)
+        {
+            return (std::uint32_t(in[0]) << 16) | (std::uint32_t(in[1]) << 8) | in[2];
+        }
+
+        std::uint32_t symbol_value(const char * in)
+        {
+            return table.values[static_cast<unsigned char>(*in)];
+        }
+
+#ifdef __SSE2__
+        __m128i in_range(__m128i v, char first, char last)
+        {
+            return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(first - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(last + 1)));
+        }
+#endif
+    }
+
+    namespace details
+    {
+        std::size_t base64_encode(std::uint8_t const * in, std::size_t size, char * out)
+        {
+            char * begin = out;
+
+#ifdef __SSE2__
+            // 12 bytes into 16 symbols: groups of 3 bytes are put into 32-bit
+            // lanes, cut into 6-bit indices, and the indices are turned into
+            // symbols by adding the offset of their range of the alphabet
+            for (; size >= 12; in += 12, size -= 12, out += 16)
+            {
+                __m128i v = _mm_setr_epi32(group(in), group(in + 3), group(in + 6), group(in + 9));
+
+                __m128i indices = _mm_or_si128(
+                    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 18), _mm_set1_epi32(0x0000003F)),
+                                 _mm_and_si128(_mm_srli_epi32(v, 4),  _mm_set1_epi32(0x00003F00))),
+                    _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 10), _mm_set1_epi32(0x003F0000)),
+                                 _mm_and_si128(_mm_slli_epi32(v, 24), _mm_set1_epi32(0x3F000000))));
+
+                __m128i offset = _mm_set1_epi8('A');
+                offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(25)),
+                                                            _mm_set1_epi8(('a' - 26) - 'A')));
+                offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(51)),
+                                                            _mm_set1_epi8(('0' - 52) - ('a' - 26))));
+                offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(61)),
+                                                            _mm_set1_epi8(('+' - 62) - ('0' - 52))));
+                offset = _mm_add_epi8(offset, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(62)),
+                                                            _mm_set1_epi8(('/' - 63) - ('+' - 62))));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_add_epi8(indices, offset));
+            }
+#endif
+
+            for (; size >= 3; in += 3, size -= 3, out += 4)
+            {
+                auto v = group(in);
+                out[0] = alphabet[v >> 18];
+                out[1] = alphabet[(v >> 12) & 0x3F];
+                out[2] = alphabet[(v >> 6) & 0x3F];
+                out[3] = alphabet[v & 0x3F];
+            }
+
+            if (size != 0)
+            {
+                std::uint8_t last[3] = { in[0], (size == 2) ? in[1] : std::uint8_t(0), 0 };
+                auto v = group(last);
+                out[0] = alphabet[v >> 18];
+                out[1] = alphabet[(v >> 12) & 0x3F];
+                out[2] = (size == 2) ? alphabet[(v >> 6) & 0x3F] : '=';
+                out[3] = '=';
+                out += 4;
+            }
+
+            return out - begin;
+        }
+
+        bool base64_decode(const char * in, std::size_t size, std::vector<std::uint8_t> & out)
+        {
+            if ((size != 0) && (size % 4 == 0) && (in[size - 1] == '='))
+                size -= (in[size - 2] == '=') ? 2 : 1;
+            if (size % 4 == 1)
+                return false;
+
+            out.resize(size / 4 * 3 + ((size % 4 != 0) ? size % 4 - 1 : 0));
+            std::uint8_t * o = out.data();
+
+#ifdef __SSE2__
+            // 16 symbols into 12 bytes: symbols are checked and turned into
+            // values by ranges, then pairs of values are merged into 12 bits
+            // and pairs of those into 24
+            for (; size >= 16; in += 16, size -= 16, o += 12)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+
+                __m128i upper   = in_range(v, 'A', 'Z');
+                __m128i lower   = in_range(v, 'a', 'z');
+                __m128i digits  = in_range(v, '0', '9');
+                __m128i plus    = _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+                __m128i slash   = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+
+                __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digits, _mm_or_si128(plus, slash)));
+                if (_mm_movemask_epi8(valid) != 0xFFFF)
+                    return false;
+
+                __m128i shift = _mm_or_si128(
+                    _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')), _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+                    _mm_or_si128(_mm_and_si128(digits, _mm_set1_epi8(52 - '0')),
+                                 _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62 - '+')),
+                                              _mm_and_si128(slash, _mm_set1_epi8(63 - '/')))));
+                __m128i values = _mm_add_epi8(v, shift);
+
+                __m128i pairs = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 6),
+                                             _mm_srli_epi16(values, 8));
+                __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+                alignas(16) std::uint32_t lanes[4];
+                _mm_store_si128(reinterpret_cast<__m128i *>(lanes), groups);
+                for (int i = 0; i != 4; ++i)
+                {
+                    o[3 * i]     = static_cast<std::uint8_t>(lanes[i] >> 16);
+                    o[3 * i + 1] = static_cast<std::uint8_t>(lanes[i] >> 8);
+                    o[3 * i + 2] = static_cast<std::uint8_t>(lanes[i]);
+                }
+            }
+#endif
+
+            for (; size >= 4; in += 4, size -= 4, o += 3)
+            {
+                auto a = symbol_value(in), b = symbol_value(in + 1), c = symbol_value(in + 2), d = symbol_value(in + 3);
+                // values are below 64, invalid has all the bits set
+                if ((a | b | c | d) & 0x40)
+                    return false;
+                auto v = (a << 18) | (b << 12) | (c << 6) | d;
+                o[0] = static_cast<std::uint8_t>(v >> 16);
+                o[1] = static_cast<std::uint8_t>(v >> 8);
+                o[2] = static_cast<std::uint8_t>(v);
+            }
+
+            if (size != 0)
+            {
+                auto a = symbol_value(in), b = symbol_value(in + 1), c = (size == 3) ? symbol_value(in + 2) : 0;
+                if ((a | b | c) & 0x40)
+                    return false;
+                auto v = (a << 18) | (b << 12) | (c << 6);
+                o[0] = static_cast<std::uint8_t>(v >> 16);
+                if (size == 3)
+                    o[1] = static_cast<std::uint8_t>(v >> 8);
+            }
+
+            return true;
+        }
+
+        bool read_base64(ParserState & st, std::vector<std::uint8_t> & out)
+        {
+            if (end_of_text(st) || (st.txt.data[st.ptr] != Quote))
+                return fail(st, ParseErrorCode::UnexpectedToken);
+
+            auto begin = st.ptr;
+            auto data = st.txt.data + begin + 1;
+            auto end = static_cast<const char *>(std::memchr(data, Quote, st.txt.size - begin - 1));
+            if (end == nullptr)
+                return fail(st, ParseErrorCode::UnexpectedEnd, st.txt.size);
+
+            if (base64_decode(data, end - data, out))
+            {
+                st.ptr = end - st.txt.data + 1;
+                return true;
+            }
+
+            // "\/" is a valid spelling of a slash in JSON
+            if (std::memchr(data, '\\', end - data) == nullptr)
+                return fail(st, ParseErrorCode::InvalidBase64, begin);
+
+            thread_local std::string buffer;
+            if (!read_string(st, buffer))
+                return false;
+            if (!base64_decode(buffer.data(), buffer.size(), out))
+                return fail(st, ParseErrorCode::InvalidBase64, begin);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,380 @@
+#include "jco/extract.h"
+
+#include <limits>
+
+namespace jco
+{
+    // Trie of pointers, a node per reference token.
+    struct PathExtractor::Node
+    {
+        // looked up by the keys in the text, without copying them
+        flat_map<std::unique_ptr<Node>>                 children;
+        // the same children by array index, for tokens that are numbers
+        std::map<std::size_t, Node *>                   elements;
+        // pointers ending at this node
+        std::vector<std::size_t>                        targets;
+    };
+
+    namespace
+    {
+        typedef PathExtractor::Node Node;
+
+        std::vector<std::string> split_pointer(std::string const & pointer)
+        {
+            if (!pointer.empty() && (pointer[0] != '/'))
+                throw std::invalid_argument("JSON pointer has to start with '/': \"" + pointer + "\"");
+
+            std::vector<std::string> res;
+            for (std::size_t i = 0; i != pointer.size(); ++i)
+            {
+                char c = pointer[i];
+                if (c == '/')
+                {
+                    res.emplace_back();
+                }
+                else if (c == '~')
+                {
+                    if ((i + 1 == pointer.size()) || ((pointer[i + 1] != '0') && (pointer[i + 1] != '1')))
+                        throw std::invalid_argument("bad escape in JSON pointer \"" + pointer + "\"");
+                    res.back().push_back((pointer[++i] == '0') ? '~' : '/');
+                }
+                else
+                {
+                    res.back().push_back(c);
+                }
+            }
+            return res;
+        }
+
+        bool to_index(std::string const & token, std::size_t & index)
+        {
+            if (token.empty() || (token.size() > 1 && token[0] == '0'))
+                return false;
+
+            index = 0;
+            for (char c : token)
+            {
+                if ((c < '0') || (c > '9') || (index > (std::numeric_limits<std::size_t>::max() - 9) / 10))
+                    return false;
+                index = index * 10 + (c - '0');
+            }
+            return true;
+        }
+
+        [[noreturn]] void throw_unexpected(details::ParserState & st, details::Token token)
+        {
+            details::unexpected(st, token);
+            details::throw_error(st.status);
+        }
+
+        struct Walker
+        {
+            utf8_text const &       txt;
+            std::vector<RawValue> & res;
+            std::size_t             remaining;
+            std::string             key_buffer;
+
+            // Returns false once all the pointers are resolved.
+            bool walk(details::ParserState & st, Node const & node)
+            {
+                using details::Token;
+
+                if ((st.ptr >= st.txt.size) || (details::skip_spaces(st) == details::SSStatus::EOT))
+                    details::check(st, details::fail(st, ParseErrorCode::UnexpectedEnd));
+
+                if (!node.targets.empty())
+                {
+                    auto begin = st.ptr;
+                    auto kind = details::next_token(st);
+                    st.ptr = begin;
+                    details::check(st, details::skip_value(st));
+
+                    // a duplicate key overwrites the value, but is counted once
+                    for (auto i : node.targets)
+                    {
+                        remaining -= !res[i].found();
+                        res[i].kind = kind;
+                        res[i].raw = boost::string_ref(txt.data + begin, st.ptr - begin);
+                    }
+
+                    if (remaining == 0)
+                        return false;
+
+                    // pointers going deeper, e.g. "/a/b" along with "/a"
+                    if (node.children.empty())
+                        return true;
+
+                    details::ParserState sub(utf8_text{ txt.data, st.ptr }, begin);
+                    return walk_children(sub, node);
+                }
+
+                return walk_children(st, node);
+            }
+
+            bool walk_children(details::ParserState & st, Node const & node)
+            {
+                using details::Token;
+
+                auto begin = st.ptr;
+                switch (details::next_token(st))
+                {
+                case Token::ObjBegin:
+                    return walk_object(st, node);
+                case Token::ArrBegin:
+                    return walk_array(st, node);
+                default:
+                    st.ptr = begin;
+                    details::check(st, details::skip_value(st));
+                    return true;
+                }
+            }
+
+            bool walk_object(details::ParserState & st, Node const & node)
+            {
+                using details::Token;
+
+                for (;;)
+                {
+                    auto token = details::next_token(st);
+                    switch (token)
+                    {
+                    case Token::ObjEnd:
+                        return true;
+                    case Token::Quote:
+                    {
+                        --st.ptr;
+                        boost::string_ref key;
+                        details::check(st, details::read_string_ref(st, key_buffer, key));
+                        token = details::next_token(st);
+                        if (token != Token::Colon)
+                            throw_unexpected(st, token);
+
+                        auto it = node.children.find(key);
+                        if (it != node.children.end())
+                        {
+                            if (!walk(st, *it->second))
+                                return false;
+                        }
+                        else
+                        {
+                            details::check(st, details::skip_value(st));
+                        }
+
+                        token = details::next_token(st);
+                        switch (token)
+                        {
+                        case Token::ObjEnd:
+                            return true;
+                        case Token::Comma:
+                            break;
+                        default:
+                            throw_unexpected(st, token);
+                        }
+                        break;
+                    }
+                    default:
+                        throw_unexpected(st, token);
+                    }
+                }
+            }
+
+            bool walk_array(details::ParserState & st, Node const & node)
+            {
+                using details::Token;
+
+                auto next = node.elements.begin();
+                for (std::size_t index = 0;; ++index)
+                {
+                    auto token = details::next_token(st);
+                    switch (token)
+                    {
+                    case Token::ArrEnd:
+                        return true;
+                    case Token::EOT:
+                    case Token::ObjEnd:
+                    case Token::Error:
+                        throw_unexpected(st, token);
+                    default:
+                        --st.ptr;
+                        if ((next != node.elements.end()) && (next->first == index))
+                        {
+                            if (!walk(st, *next->second))
+                                return false;
+                            ++next;
+                        }
+                        else
+                        {
+                            details::check(st, details::skip_value(st));
+                        }
+
+                        token = details::next_token(st);
+                        switch (token)
+                        {
+                        case Token::ArrEnd:
+                            return true;
+                        case Token::Comma:
+                            break;
+                        default:
+                            throw_unexpected(st, token);
+                        }
+                    }
+                }
+            }
+        };
+    }
+
+    namespace
+    {
+        // Moves the parser to the value at the pointer, false if there is none.
+        bool find_value(Parser & parser, std::vector<std::string> const & tokens)
+        {
+            using details::Token;
+
+            for (auto const & token : tokens)
+            {
+                auto begin = parser.position();
+                switch (parser.next_token())
+                {
+                case Token::ObjBegin:
+                    for (;;)
+                    {
+                        auto key_begin = parser.position();
+                        auto next = parser.next_token();
+                        if (next == Token::ObjEnd)
+                            return false;
+                        if (next != Token::Quote)
+                            details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, key_begin));
+
+                        parser.seek(key_begin);
+                        auto key = parser.parse_string();
+                        parser.expect(Token::Colon);
+                        if (key == token)
+                            break;
+
+                        parser.skip_value();
+                        auto separator = parser.position();
+                        next = parser.next_token();
+                        if (next == Token::ObjEnd)
+                            return false;
+                        if (next != Token::Comma)
+                            details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, separator));
+                    }
+                    break;
+
+                case Token::ArrBegin:
+                {
+                    std::size_t index;
+                    if (!to_index(token, index))
+                        return false;
+
+                    auto element = parser.position();
+                    if (parser.next_token() == Token::ArrEnd)
+                        return false;
+                    parser.seek(element);
+
+                    for (; index != 0; --index)
+                    {
+                        parser.skip_value();
+                        auto separator = parser.position();
+                        auto next = parser.next_token();
+                        if (next == Token::ArrEnd)
+                            return false;
+                        if (next != Token::Comma)
+                            details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, separator));
+                    }
+                    break;
+                }
+
+                default:
+                    // a scalar has no children, but has to be valid
+                    parser.seek(begin);
+                    parser.skip_value();
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    ArrayCursor::ArrayCursor(utf8_text const & txt, std::string const & pointer, ParseOptions const & options)
+        : parser_(txt, options)
+        , found_(find_value(parser_, split_pointer(pointer)))
+        , state_(found_ ? State::First : State::End)
+    {
+        if (found_)
+            parser_.expect(details::Token::ArrBegin);
+    }
+
+    bool ArrayCursor::next()
+    {
+        using details::Token;
+
+        if (state_ == State::End)
+            return false;
+
+        auto begin = parser_.position();
+        auto token = parser_.next_token();
+
+        if (state_ == State::First)
+        {
+            if (token == Token::ArrEnd)
+            {
+                state_ = State::End;
+                return false;
+            }
+            state_ = State::Next;
+            parser_.seek(begin);
+            return true;
+        }
+
+        switch (token)
+        {
+        case Token::Comma:
+            return true;
+        case Token::ArrEnd:
+            state_ = State::End;
+            return false;
+        default:
+            details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, begin));
+        }
+    }
+
+    PathExtractor::PathExtractor(std::vector<std::string> const & pointers)
+        : root_(new Node)
+        , pointers_num_(pointers.size())
+    {
+        for (std::size_t i = 0; i != pointers.size(); ++i)
+        {
+            Node * node = root_.get();
+            for (auto const & token : split_pointer(pointers[i]))
+            {
+                auto & child = node->children[token];
+                if (!child)
+                {
+                    child.reset(new Node);
+                    std::size_t index;
+                    if (to_index(token, index))
+                        node->elements[index] = child.get();
+                }
+                node = child.get();
+            }
+            node->targets.push_back(i);
+        }
+    }
+
+    PathExtractor::~PathExtractor() {}
+
+    std::vector<RawValue> PathExtractor::extract(utf8_text const & txt) const
+    {
+        std::vector<RawValue> res(pointers_num_);
+        if (pointers_num_ == 0)
+            return res;
+
+        details::ParserState st(txt, 0);
+        details::skip_BOM(st);
+
+        Walker walker{ txt, res, pointers_num_, std::string() };
+        walker.walk(st, *root_);
+        return res;
+    }
+}
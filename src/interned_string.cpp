@@ -0,0 +1,76 @@
+#include "jco/interned_string.h"
+
+#include <cstdint>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+
+namespace jco
+{
+    namespace
+    {
+        // FNV-1a
+        struct ref_hash
+        {
+            std::size_t operator() (boost::string_ref str) const
+            {
+                std::uint64_t h = 14695981039346656037ull;
+                for (char c : str)
+                {
+                    h ^= static_cast<unsigned char>(c);
+                    h *= 1099511628211ull;
+                }
+                return static_cast<std::size_t>(h);
+            }
+        };
+
+        // Keys point into the strings they map to, so looking up a string
+        // doesn't allocate.
+        struct Shard
+        {
+            std::mutex                                                                  mutex;
+            std::unordered_map<boost::string_ref, std::unique_ptr<std::string>, ref_hash> strings;
+        };
+
+        // threads interning different strings mostly take different locks
+        const std::size_t shards_num = 64;
+
+        Shard & shard(std::size_t hash)
+        {
+            static Shard shards[shards_num];
+            return shards[(hash >> 16) % shards_num];
+        }
+
+        std::string const & empty_string()
+        {
+            static const std::string empty;
+            return empty;
+        }
+
+        std::string const * intern(boost::string_ref str)
+        {
+            if (str.empty())
+                return &empty_string();
+
+            auto & s = shard(ref_hash()(str));
+            std::lock_guard<std::mutex> lock(s.mutex);
+
+            auto it = s.strings.find(str);
+            if (it != s.strings.end())
+                return it->second.get();
+
+            std::unique_ptr<std::string> stored(new std::string(str.data(), str.size()));
+            auto res = stored.get();
+            s.strings.emplace(boost::string_ref(*res), std::move(stored));
+            return res;
+        }
+    }
+
+    interned_string::interned_string()
+        : str_(&empty_string())
+    {}
+
+    interned_string::interned_string(boost::string_ref str)
+        : str_(intern(str))
+    {}
+}
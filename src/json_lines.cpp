@@ -0,0 +1,365 @@
+#include "jco/json_lines.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace jco
+{
+    namespace details
+    {
+        namespace
+        {
+            struct Chunk
+            {
+                std::shared_ptr<std::string>    storage;
+                utf8_text                       txt;
+            };
+
+            struct BlockSource
+            {
+                virtual bool next(Chunk &) = 0;
+
+                virtual ~BlockSource() {}
+            };
+
+            const char * find_newline(const char * begin, const char * end)
+            {
+                auto res = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+                return res ? res : end;
+            }
+
+            // Blocks point into the text, nothing is copied.
+            struct TextSource : BlockSource
+            {
+                TextSource(utf8_text const & txt, std::size_t block_size)
+                    : pos_(txt.data)
+                    , end_(txt.data + txt.size)
+                    , block_size_(block_size)
+                {}
+
+                bool next(Chunk & chunk) override
+                {
+                    if (pos_ == end_)
+                        return false;
+
+                    auto block_end = (static_cast<std::size_t>(end_ - pos_) > block_size_)
+                        ? find_newline(pos_ + block_size_, end_)
+                        : end_;
+                    if (block_end != end_)
+                        ++block_end;
+
+                    chunk.txt = { pos_, static_cast<std::size_t>(block_end - pos_) };
+                    pos_ = block_end;
+                    return true;
+                }
+
+            private:
+                const char *        pos_;
+                const char * const  end_;
+                std::size_t const   block_size_;
+            };
+
+            // Reads block_size bytes at a time and cuts them after the last
+            // newline, the tail is carried over to the next block.
+            struct StreamSource : BlockSource
+            {
+                StreamSource(std::istream & in, std::size_t block_size)
+                    : in_(in)
+                    , block_size_(block_size)
+                {}
+
+                bool next(Chunk & chunk) override
+                {
+                    auto buf = std::make_shared<std::string>();
+                    buf->swap(carry_);
+
+                    // the carried tail has no newline in it
+                    std::size_t searched = buf->size();
+                    while (in_ && (buf->size() < block_size_))
+                        read_more(*buf, block_size_ - buf->size());
+
+                    while (in_)
+                    {
+                        auto rend = buf->rend() - searched;
+                        auto nl = std::find(buf->rbegin(), rend, '\n');
+                        if (nl != rend)
+                        {
+                            std::size_t line_end = buf->rend() - nl;
+                            carry_.assign(*buf, line_end, std::string::npos);
+                            buf->resize(line_end);
+                            break;
+                        }
+
+                        // a line longer than a block
+                        searched = buf->size();
+                        read_more(*buf, block_size_);
+                    }
+
+                    if (buf->empty())
+                        return false;
+
+                    chunk.storage = buf;
+                    chunk.txt = { buf->data(), buf->size() };
+                    return true;
+                }
+
+            private:
+                void read_more(std::string & buf, std::size_t n)
+                {
+                    auto size = buf.size();
+                    buf.resize(size + n);
+                    in_.read(&buf[size], n);
+                    buf.resize(size + static_cast<std::size_t>(in_.gcount()));
+                    if (in_.bad())
+                        throw std::ios_base::failure("jco: reading JSON lines failed");
+                }
+
+            private:
+                std::istream &      in_;
+                std::size_t const   block_size_;
+                std::string         carry_;
+            };
+
+            bool is_blank(const char * begin, const char * end)
+            {
+                for (; begin != end; ++begin)
+                {
+                    switch (*begin)
+                    {
+                    case ' ':
+                    case '\t':
+                    case '\r':
+                        break;
+                    default:
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            void split_lines(utf8_text const & txt, std::vector<utf8_text> & lines)
+            {
+                auto pos = txt.data;
+                auto end = txt.data + txt.size;
+                while (pos != end)
+                {
+                    auto line_end = find_newline(pos, end);
+                    if (!is_blank(pos, line_end))
+                        lines.push_back({ pos, static_cast<std::size_t>(line_end - pos) });
+                    pos = (line_end == end) ? end : line_end + 1;
+                }
+            }
+
+            struct Task
+            {
+                std::size_t index;
+                Chunk       chunk;
+            };
+
+            // One thread reads blocks, the pool parses them and the calling
+            // thread delivers results in order. Blocks are counted from being
+            // read till being delivered, the reader waits while max_blocks
+            // are in flight.
+            class Pipeline
+            {
+            public:
+                Pipeline(JsonLinesOptions const & options, BlockDecoder const & decoder)
+                    : decoder_(decoder)
+                    , threads_num_(options.threads
+                                   ? options.threads
+                                   : std::max<std::size_t>(1, std::thread::hardware_concurrency()))
+                    , max_blocks_(options.max_blocks ? options.max_blocks : 2 * threads_num_)
+                {}
+
+                void run(BlockSource & src)
+                {
+                    threads_guard tg(*this);
+
+                    tg.threads.emplace_back([this, &src] { read(src); });
+                    for (std::size_t i = 0; i != threads_num_; ++i)
+                        tg.threads.emplace_back([this] { work(); });
+
+                    deliver();
+                }
+
+            private:
+                struct threads_guard
+                {
+                    explicit threads_guard(Pipeline & p)
+                        : p_(p)
+                    {}
+
+                    ~threads_guard()
+                    {
+                        {
+                            std::lock_guard<std::mutex> lock(p_.mutex_);
+                            p_.stop_ = true;
+                        }
+                        p_.reader_cv_.notify_all();
+                        p_.workers_cv_.notify_all();
+
+                        for (auto & t : threads)
+                            t.join();
+                    }
+
+                    std::vector<std::thread> threads;
+
+                private:
+                    Pipeline & p_;
+                };
+
+                void read(BlockSource & src)
+                {
+                    for (;;)
+                    {
+                        {
+                            std::unique_lock<std::mutex> lock(mutex_);
+                            reader_cv_.wait(lock, [this] { return stop_ || (in_flight_ < max_blocks_); });
+                            if (stop_)
+                                return;
+                        }
+
+                        Task task;
+                        Delivery error;
+                        bool more = false;
+                        try
+                        {
+                            more = src.next(task.chunk);
+                        }
+                        catch (...)
+                        {
+                            auto e = std::current_exception();
+                            error = [e] { std::rethrow_exception(e); };
+                        }
+
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            if (more)
+                            {
+                                task.index = read_blocks_++;
+                                ++in_flight_;
+                                tasks_.push_back(std::move(task));
+                            }
+                            else
+                            {
+                                if (error)
+                                {
+                                    done_[read_blocks_++] = std::move(error);
+                                    ++in_flight_;
+                                }
+                                eot_ = true;
+                            }
+                        }
+
+                        if (more)
+                        {
+                            workers_cv_.notify_one();
+                        }
+                        else
+                        {
+                            workers_cv_.notify_all();
+                            consumer_cv_.notify_one();
+                            return;
+                        }
+                    }
+                }
+
+                void work()
+                {
+                    for (;;)
+                    {
+                        Task task;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex_);
+                            workers_cv_.wait(lock, [this] { return stop_ || eot_ || !tasks_.empty(); });
+                            if (stop_ || tasks_.empty())
+                                return;
+                            task = std::move(tasks_.front());
+                            tasks_.pop_front();
+                        }
+
+                        Delivery delivery;
+                        try
+                        {
+                            LinesBlock block;
+                            split_lines(task.chunk.txt, block.lines);
+                            delivery = decoder_(block);
+                        }
+                        catch (...)
+                        {
+                            auto e = std::current_exception();
+                            delivery = [e] { std::rethrow_exception(e); };
+                        }
+                        task.chunk.storage.reset();
+
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            done_[task.index] = std::move(delivery);
+                        }
+                        consumer_cv_.notify_one();
+                    }
+                }
+
+                void deliver()
+                {
+                    for (std::size_t next = 0;; ++next)
+                    {
+                        Delivery delivery;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex_);
+                            consumer_cv_.wait(lock, [this, next] {
+                                return done_.count(next) || (eot_ && (next == read_blocks_));
+                            });
+
+                            auto it = done_.find(next);
+                            if (it == done_.end())
+                                return;
+                            delivery = std::move(it->second);
+                            done_.erase(it);
+                        }
+
+                        delivery();
+
+                        {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            --in_flight_;
+                        }
+                        reader_cv_.notify_one();
+                    }
+                }
+
+            private:
+                BlockDecoder const &    decoder_;
+                std::size_t const       threads_num_;
+                std::size_t const       max_blocks_;
+
+                std::mutex              mutex_;
+                std::condition_variable reader_cv_, workers_cv_, consumer_cv_;
+
+                std::deque<Task>                    tasks_;
+                std::map<std::size_t, Delivery>     done_;
+                std::size_t                         read_blocks_    = 0;
+                std::size_t                         in_flight_      = 0;
+                bool                                eot_            = false;
+                bool                                stop_           = false;
+            };
+        }
+
+        void run_json_lines(std::istream & in, JsonLinesOptions const & options, BlockDecoder decoder)
+        {
+            StreamSource src(in, options.block_size);
+            Pipeline(options, decoder).run(src);
+        }
+
+        void run_json_lines(utf8_text const & txt, JsonLinesOptions const & options, BlockDecoder decoder)
+        {
+            TextSource src(txt, options.block_size);
+            Pipeline(options, decoder).run(src);
+        }
+    }
+}
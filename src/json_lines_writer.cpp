@@ -0,0 +1,318 @@
+#include "jco/json_lines.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <streambuf>
+#include <condition_variable>
+
+namespace jco
+{
+    namespace
+    {
+        // Appends everything written through it to a string.
+        struct string_sink : std::streambuf
+        {
+            explicit string_sink(std::string & str)
+                : str_(str)
+            {}
+
+        protected:
+            int_type overflow(int_type c) override
+            {
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                    str_.push_back(traits_type::to_char_type(c));
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char * s, std::streamsize n) override
+            {
+                str_.append(s, static_cast<std::size_t>(n));
+                return n;
+            }
+
+        private:
+            std::string & str_;
+        };
+
+        // Buffer of a single thread, the mutex is taken by the owner for every
+        // record and by the commit thread once per commit.
+        struct Producer
+        {
+            Producer()
+                : sink(data)
+                , backend(&sink)
+                , out(backend, serialization::Style::SingleLine)
+            {}
+
+            std::mutex                  mutex;
+            std::string                 data;
+
+            string_sink                 sink;
+            std::ostream                backend;
+            serialization::out_stream   out;
+
+            // taken by a thread till it exits, then reused by another one
+            std::atomic<bool>           owned{ true };
+        };
+
+        // Gives the producer up when the thread exits, its pending lines are
+        // still committed. The writer may be gone by then.
+        struct ProducerLease
+        {
+            ProducerLease(std::uint64_t writer_id, std::shared_ptr<Producer> const & producer)
+                : writer_id(writer_id)
+                , producer(producer)
+            {}
+
+            ProducerLease(ProducerLease && other)
+                : writer_id(other.writer_id)
+                , producer(std::move(other.producer))
+            {}
+
+            ProducerLease& operator = (ProducerLease && other)
+            {
+                release();
+                writer_id = other.writer_id;
+                producer = std::move(other.producer);
+                return *this;
+            }
+
+            ~ProducerLease()
+            {
+                release();
+            }
+
+            void release()
+            {
+                if (auto p = producer.lock())
+                    p->owned = false;
+                producer.reset();
+            }
+
+            std::uint64_t           writer_id;
+            std::weak_ptr<Producer> producer;
+        };
+
+        // thread local caches below refer to writers by id, not by address
+        std::atomic<std::uint64_t> last_writer_id(0);
+    }
+
+    struct JsonLinesWriter::implementation
+    {
+        implementation(std::ostream & out, JsonLinesWriterOptions const & options)
+            : out(out)
+            , options(options)
+            , id(++last_writer_id)
+        {}
+
+        Producer & local_producer();
+
+        void request_commit();
+        void commit_loop();
+        bool commit();
+
+        std::ostream &                  out;
+        JsonLinesWriterOptions const    options;
+        std::uint64_t const             id;
+
+        // one per thread appending at the same time
+        std::mutex                                  producers_mutex;
+        std::vector<std::shared_ptr<Producer>>      producers;
+
+        std::mutex              commit_mutex;
+        std::condition_variable commit_cv, committed_cv;
+        std::uint64_t           requested   = 0;
+        std::uint64_t           committed   = 0;
+        bool                    urgent      = false;
+        bool                    stop        = false;
+        bool                    failed      = false;
+
+        // touched by the commit thread only
+        std::string             batch;
+
+        std::thread             commit_thread;
+    };
+
+    Producer & JsonLinesWriter::implementation::local_producer()
+    {
+        thread_local std::uint64_t  cached_id       = 0;
+        thread_local Producer *     cached_producer = nullptr;
+        // producers of all the writers the thread appended to
+        thread_local std::vector<ProducerLease> leases;
+
+        if (cached_id == id)
+            return *cached_producer;
+
+        for (auto const & lease : leases)
+        {
+            if (lease.writer_id != id)
+                continue;
+            cached_id = id;
+            cached_producer = lease.producer.lock().get();
+            return *cached_producer;
+        }
+
+        std::shared_ptr<Producer> producer;
+        {
+            std::lock_guard<std::mutex> lock(producers_mutex);
+            for (auto const & p : producers)
+            {
+                bool owned = false;
+                if (p->owned.compare_exchange_strong(owned, true))
+                {
+                    producer = p;
+                    break;
+                }
+            }
+            if (!producer)
+            {
+                producer = std::make_shared<Producer>();
+                producers.push_back(producer);
+            }
+        }
+
+        // leases of destroyed writers are dropped on the way
+        leases.erase(std::remove_if(leases.begin(), leases.end(), [] (ProducerLease const & lease) {
+            return lease.producer.expired();
+        }), leases.end());
+        leases.emplace_back(id, producer);
+
+        cached_id = id;
+        cached_producer = producer.get();
+        return *producer;
+    }
+
+    void JsonLinesWriter::implementation::request_commit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(commit_mutex);
+            urgent = true;
+        }
+        commit_cv.notify_one();
+    }
+
+    void JsonLinesWriter::implementation::commit_loop()
+    {
+        std::unique_lock<std::mutex> lock(commit_mutex);
+        for (;;)
+        {
+            commit_cv.wait_for(lock, std::chrono::milliseconds(options.commit_interval_ms), [this] {
+                return stop || urgent || (requested != committed);
+            });
+
+            bool stopping = stop;
+            auto target = requested;
+            urgent = false;
+
+            lock.unlock();
+            bool ok = commit();
+            lock.lock();
+
+            failed |= !ok;
+            committed = target;
+            committed_cv.notify_all();
+
+            if (stopping)
+                return;
+        }
+    }
+
+    bool JsonLinesWriter::implementation::commit()
+    {
+        std::vector<Producer *> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(producers_mutex);
+            for (auto const & p : producers)
+                snapshot.push_back(p.get());
+        }
+
+        bool written = false;
+        for (auto p : snapshot)
+        {
+            {
+                // the producer continues with the (empty) buffer of the
+                // previous commit, so both keep their capacity
+                std::lock_guard<std::mutex> lock(p->mutex);
+                if (p->data.empty())
+                    continue;
+                batch.swap(p->data);
+            }
+
+            out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            batch.clear();
+            written = true;
+        }
+
+        if (written)
+            out.flush();
+        return !out.fail();
+    }
+
+    JsonLinesWriter::JsonLinesWriter(std::ostream & out, JsonLinesWriterOptions const & options)
+        : pimpl(new implementation(out, options))
+    {
+        pimpl->commit_thread = std::thread([this] { pimpl->commit_loop(); });
+    }
+
+    JsonLinesWriter::~JsonLinesWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(pimpl->commit_mutex);
+            pimpl->stop = true;
+        }
+        pimpl->commit_cv.notify_one();
+        pimpl->commit_thread.join();
+    }
+
+    void JsonLinesWriter::append(serialization::ISerializable const & obj)
+    {
+        append_record([] (serialization::out_stream & out, void const * obj) {
+            static_cast<serialization::ISerializable const *>(obj)->serialize(out);
+        }, &obj);
+    }
+
+    void JsonLinesWriter::append_record(RecordWriter write, void const * obj)
+    {
+        auto & p = pimpl->local_producer();
+
+        std::size_t size;
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+
+            auto mark = p.data.size();
+            try
+            {
+                write(p.out, obj);
+            }
+            catch (...)
+            {
+                p.data.resize(mark);
+                p.out.reset();
+                throw;
+            }
+            p.out.reset();
+            p.data.push_back('\n');
+            size = p.data.size();
+        }
+
+        if (size >= pimpl->options.buffer_size)
+            pimpl->request_commit();
+    }
+
+    void JsonLinesWriter::flush()
+    {
+        std::unique_lock<std::mutex> lock(pimpl->commit_mutex);
+
+        auto target = ++pimpl->requested;
+        pimpl->commit_cv.notify_one();
+        pimpl->committed_cv.wait(lock, [this, target] { return pimpl->committed >= target; });
+
+        if (pimpl->failed)
+            throw std::ios_base::failure("jco: writing JSON lines failed");
+    }
+}
@@ -1,6 +1,10 @@
 #include "jco/serialization.h"
 
+#include <array>
 #include <stack>
+#include <vector>
+#include <thread>
+#include <exception>
 #include <boost/range/algorithm/find.hpp>
 
 #include "printer.h"
@@ -21,7 +25,14 @@ namespace jco
 
         struct out_stream::implementation
         {
-            PrinterPtr printer;
+            PrinterPtr      printer;
+            std::ostream *  backend;
+            Style           style;
+
+            SerializationStats stats;
+            std::size_t depth = 0;
+
+            void enter_container();
 
             template<class Value>
             out_stream& write(value_tag<Value> v);
@@ -44,15 +55,21 @@ namespace jco
             template<size_t N>
             void expect(StateList<N> states) const;
 
+            void restart();
+
             explicit implementation(out_stream & ostream)
                 : ostream_(ostream)
             {
                 push_state(State::Initial);
             }
 
+            // nothing or a complete value has to be written, unless writing
+            // it was interrupted by an exception
             ~implementation() noexcept(false)
             {
-                if ((state_.size() != 1) || (state_.top() != State::Terminal))
+                if (std::uncaught_exception())
+                    return;
+                if ((state_.size() != 1) || ((state_.top() != State::Terminal) && (state_.top() != State::Initial)))
                     throw SerializationError();
             }
 
@@ -107,6 +124,7 @@ namespace jco
         out_stream& out_stream::implementation::write(value_tag<Value> v)
         {
             expect(State::Key);
+            JCO_STATS(++stats.values);
             printer->print(v.value);
             state_.pop();
             expect(State::ObjectBegin | State::Object);
@@ -117,6 +135,7 @@ namespace jco
         out_stream& out_stream::implementation::write(null_value_tag)
         {
             expect(State::Key);
+            JCO_STATS(++stats.values);
             printer->print(nullptr);
             state_.pop();
             expect(State::ObjectBegin | State::Object);
@@ -124,6 +143,13 @@ namespace jco
             return ostream_;
         }
 
+        void out_stream::implementation::enter_container()
+        {
+            ++stats.containers;
+            if (++depth > stats.max_depth)
+                stats.max_depth = depth;
+        }
+
         State out_stream::implementation::current_state() const
         {
             if (state_.empty())
@@ -145,6 +171,7 @@ namespace jco
         template<class Value>
         out_stream& out_stream::implementation::write_primitive(Value v)
         {
+            JCO_STATS(++stats.values);
             switch (current_state())
             {
             case State::Initial:
@@ -182,6 +209,7 @@ namespace jco
                 throw SerializationError();
             }
 
+            JCO_STATS(pimpl->enter_container());
             pimpl->printer->open_array();
             pimpl->push_state(State::ArrayBegin);
         }
@@ -191,6 +219,7 @@ namespace jco
             details::expect(pimpl->pop_state(), State::ArrayBegin | State::Array);
 
             pimpl->printer->close_array();
+            JCO_STATS(--pimpl->depth);
 
             if (pimpl->current_state() == State::ValueArr)
                 pimpl->pop_state();
@@ -215,6 +244,7 @@ namespace jco
                 throw SerializationError();
             }
 
+            JCO_STATS(pimpl->enter_container());
             pimpl->printer->open_object();
             pimpl->push_state(State::ObjectBegin);
         }
@@ -224,6 +254,7 @@ namespace jco
             details::expect(pimpl->pop_state(), State::ObjectBegin | State::Object);
 
             pimpl->printer->close_object();
+            JCO_STATS(--pimpl->depth);
 
             if (pimpl->current_state() == State::ValueObj)
                 pimpl->pop_state();
@@ -236,6 +267,31 @@ namespace jco
             return pimpl->write(x);
         }
 
+        out_stream& out_stream::operator <<(integer_value_tag x)
+        {
+            return pimpl->write(x);
+        }
+
+        out_stream& out_stream::operator <<(unsigned_value_tag x)
+        {
+            return pimpl->write(x);
+        }
+
+        out_stream& out_stream::operator <<(fixed_value_tag x)
+        {
+            return pimpl->write(x);
+        }
+
+        out_stream& out_stream::operator <<(base64_value_tag x)
+        {
+            return pimpl->write(x);
+        }
+
+        out_stream& out_stream::operator <<(raw_value_tag x)
+        {
+            return pimpl->write(x);
+        }
+
         out_stream& out_stream::operator <<(string_value_tag s)
         {
             return pimpl->write(s);
@@ -266,6 +322,7 @@ namespace jco
             default:
                 throw SerializationError();
             }
+            JCO_STATS(++pimpl->stats.keys);
             pimpl->printer->key(key.name());
             pimpl->push_state(State::Key);
             return *this;
@@ -286,6 +343,36 @@ namespace jco
             return pimpl->write_primitive(x);
         }
 
+        out_stream& out_stream::operator << (long long x)
+        {
+            return pimpl->write_primitive(x);
+        }
+
+        out_stream& out_stream::operator << (unsigned long long x)
+        {
+            return pimpl->write_primitive(x);
+        }
+
+        out_stream& out_stream::operator << (fixed_tag x)
+        {
+            return pimpl->write_primitive(x);
+        }
+
+        out_stream& out_stream::operator << (base64_tag x)
+        {
+            return pimpl->write_primitive(x);
+        }
+
+        out_stream& out_stream::operator << (raw_tag x)
+        {
+            return pimpl->write_primitive(x);
+        }
+
+        out_stream& out_stream::operator << (boost::string_ref str)
+        {
+            return pimpl->write_primitive(str);
+        }
+
         out_stream& out_stream::operator << (const char * str)
         {
             return pimpl->write_primitive(boost::string_ref(str));
@@ -296,14 +383,129 @@ namespace jco
             return pimpl->write_primitive(nullptr);
         }
 
+        namespace
+        {
+            // fewer elements are not worth a thread
+            const std::size_t min_parallel_chunk = 256;
+        }
+
+        void out_stream::write_parallel(std::size_t count, std::size_t threads, ChunkSerializer const & serialize_chunk)
+        {
+            array_scope as(*this);
+
+            if (threads == 0)
+                threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+
+            std::size_t chunks_num = std::min(threads, (count + min_parallel_chunk - 1) / min_parallel_chunk);
+            if (chunks_num <= 1)
+            {
+                serialize_chunk(*this, 0, count);
+                return;
+            }
+
+            // Every chunk is written as a sequence of array elements by a stream
+            // that starts inside of an array at the current indentation.
+            std::vector<std::string>        texts(chunks_num);
+            std::vector<std::exception_ptr> errors(chunks_num);
+            std::vector<SerializationStats> stats(chunks_num);
+
+            auto work = [&] (std::size_t chunk) {
+                try
+                {
+                    std::ostringstream ss;
+                    {
+                        out_stream chunk_out(ss, Style::SingleLine);
+                        chunk_out.pimpl->printer = pimpl->printer->clone(ss);
+                        chunk_out.pimpl->set_current_state(State::Terminal);
+                        chunk_out.pimpl->push_state(State::ArrayBegin);
+                        // depths are counted from the top of the document
+                        chunk_out.pimpl->depth = pimpl->depth;
+
+                        serialize_chunk(chunk_out, count * chunk / chunks_num, count * (chunk + 1) / chunks_num);
+
+                        details::expect(chunk_out.pimpl->pop_state(), State::ArrayBegin | State::Array);
+                        stats[chunk] = chunk_out.pimpl->stats;
+                    }
+                    texts[chunk] = ss.str();
+                }
+                catch (...)
+                {
+                    errors[chunk] = std::current_exception();
+                }
+            };
+
+            {
+                std::vector<std::thread> workers;
+                struct join_guard
+                {
+                    std::vector<std::thread> & workers;
+                    ~join_guard()
+                    {
+                        for (auto & t : workers)
+                            t.join();
+                    }
+                } jg{ workers };
+
+                for (std::size_t chunk = 1; chunk != chunks_num; ++chunk)
+                    workers.emplace_back(work, chunk);
+                work(0);
+            }
+
+            for (std::size_t chunk = 0; chunk != chunks_num; ++chunk)
+            {
+                if (errors[chunk])
+                    std::rethrow_exception(errors[chunk]);
+
+                auto & total = pimpl->stats;
+                total.values        += stats[chunk].values;
+                total.keys          += stats[chunk].keys;
+                total.containers    += stats[chunk].containers;
+                total.max_depth     = std::max(total.max_depth, stats[chunk].max_depth);
+
+                if (texts[chunk].empty())
+                    continue;
+
+                if (pimpl->current_state() == State::Array)
+                    pimpl->printer->separate_array_elements();
+                else
+                    pimpl->set_current_state(State::Array);
+                pimpl->printer->raw(texts[chunk]);
+            }
+        }
+
         PrinterPtr make_printer(std::ostream & backend, Style style);
 
+        void out_stream::implementation::restart()
+        {
+            if ((state_.size() != 1) || (state_.top() != State::Terminal))
+            {
+                // printers track nesting too
+                printer = make_printer(*backend, style);
+                depth = 0;
+            }
+
+            state_ = std::stack<State>();
+            push_state(State::Initial);
+        }
+
         out_stream::out_stream(std::ostream & backend, Style style)
             : pimpl(new implementation(*this))
         {
             pimpl->printer = make_printer(backend, style);
+            pimpl->backend = &backend;
+            pimpl->style = style;
         }
 
         out_stream::~out_stream() {}
+
+        void out_stream::reset()
+        {
+            pimpl->restart();
+        }
+
+        SerializationStats const & out_stream::stats() const
+        {
+            return pimpl->stats;
+        }
     }
 }
@@ -1,8 +1,15 @@
 #include "jco/parser.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <boost/locale/encoding_utf.hpp>
 #include <boost/range/algorithm/copy.hpp>
 
@@ -67,10 +74,37 @@ namespace jco
             return st.ptr == st.txt.size;
         }
 
+        bool fail(ParserState & st, ParseErrorCode code, std::size_t offset)
+        {
+            // the first error is the cause, the rest is unwinding
+            if (st.status.code == ParseErrorCode::None)
+            {
+                st.status.code = code;
+                st.status.offset = offset;
+            }
+            return false;
+        }
+
+        bool fail(ParserState & st, ParseErrorCode code)
+        {
+            return fail(st, code, st.ptr);
+        }
+
+        bool unexpected(ParserState & st, Token token)
+        {
+            if (token == Token::EOT)
+                return fail(st, ParseErrorCode::UnexpectedEnd);
+            // all tokens but EOT and Error are a single consumed symbol
+            return fail(st, ParseErrorCode::UnexpectedToken, st.ptr - 1);
+        }
+
         Token next_token(ParserState & st)
         {
             if (st.ptr >= st.txt.size)
-                throw ParseError();
+            {
+                fail(st, ParseErrorCode::UnexpectedEnd);
+                return Token::Error;
+            }
 
             if (skip_spaces(st) == SSStatus::EOT)
                 return Token::EOT;
@@ -96,13 +130,32 @@ namespace jco
             case 'n':
                 return Token::Constant;
             default:
-                throw ParseError();
+                fail(st, ParseErrorCode::InvalidSymbol, st.ptr - 1);
+                return Token::Error;
             }
         }
 
-        std::uint16_t read_utf16_symbol(ParserState & st)
+        bool expect_eot(ParserState & st)
+        {
+            if (end_of_text(st) || (skip_spaces(st) == SSStatus::EOT))
+                return true;
+            return fail(st, ParseErrorCode::TrailingData);
+        }
+
+        bool read_utf16_symbol(ParserState & st, std::uint16_t & res)
         {
-            std::uint16_t res = 0;
+            res = 0;
+
+            if (st.options.trusted)
+            {
+                // digits by their low bits, letters of both cases are 9 off
+                for (size_t i = 0; i != 4; ++i, ++st.ptr)
+                {
+                    auto c = static_cast<unsigned char>(get_symbol(st));
+                    res = (res << 4) | ((c & 0x0F) + (c >> 6) * 9);
+                }
+                return true;
+            }
 
             for (size_t i = 0; i != 4; ++i, ++st.ptr)
             {
@@ -111,41 +164,124 @@ namespace jco
                 char c = get_symbol(st);
                 if (c >= '0' && c <= '9')
                     res += c - '0';
-                if (c >= 'a' && c <= 'f')
+                else if (c >= 'a' && c <= 'f')
                     res += 10 + c - 'a';
-                if (c >= 'A' && c <= 'F')
+                else if (c >= 'A' && c <= 'F')
                     res += 10 + c - 'A';
+                else
+                    return fail(st, ParseErrorCode::InvalidEscape);
             }
 
-            return res;
+            return true;
         }
 
         template<class OutIter>
-        void convert_to_utf8(char16_t c, OutIter out)
+        OutIter convert_to_utf8(char16_t c, OutIter out)
         {
             auto str = boost::locale::conv::utf_to_utf<char>(&c, &c + 1);
-            boost::copy(str, out);
+            return boost::copy(str, out);
         }
 
         template<class OutIter>
-        void convert_to_utf8(char16_t c1, char16_t c2, OutIter out)
+        OutIter convert_to_utf8(char16_t c1, char16_t c2, OutIter out)
         {
             auto c = { c1, c2 };
             auto str = boost::locale::conv::utf_to_utf<char>(std::begin(c), std::end(c));
-            boost::copy(str, out);
+            return boost::copy(str, out);
         }
 
-        std::string read_string(ParserState & st)
+        // Decodes an escape sequence, st.ptr is right after the backslash.
+        template<class OutIter>
+        bool read_escape(ParserState & st, OutIter & out)
         {
-            assert(get_symbol(st) == Quote);
+            if (end_of_text(st))
+                return fail(st, ParseErrorCode::UnexpectedEnd);
+
+            auto c = get_symbol(st);
+            switch (c)
+            {
+            case Quote:
+            case '\\':
+            case '/':
+                *out++ = c;
+                ++st.ptr;
+                return true;
+            case 'b':
+                *out++ = 0x08;
+                ++st.ptr;
+                return true;
+            case 'f':
+                *out++ = 0x0C;
+                ++st.ptr;
+                return true;
+            case 'n':
+                *out++ = SkipSymbol::LF;
+                ++st.ptr;
+                return true;
+            case 'r':
+                *out++ = SkipSymbol::CR;
+                ++st.ptr;
+                return true;
+            case 't':
+                *out++ = SkipSymbol::Tab;
+                ++st.ptr;
+                return true;
+            case 'u':
+            {
+                ++st.ptr;
+                if (st.ptr + 4 > st.txt.size)
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
+                std::uint16_t utf16;
+                if (!read_utf16_symbol(st, utf16))
+                    return false;
+                if ((utf16 < 0xD800) || (utf16 > 0xDFFF))
+                {
+                    out = convert_to_utf8(utf16, out);
+                }
+                else
+                {
+                    if ((st.ptr + 5 >= st.txt.size) || (get_symbol(st) != '\\') || (st.txt.data[st.ptr + 1] != 'u'))
+                        return fail(st, ParseErrorCode::InvalidEscape);
+                    st.ptr += 2;
+                    std::uint16_t low;
+                    if (!read_utf16_symbol(st, low))
+                        return false;
+                    out = convert_to_utf8(utf16, low, out);
+                }
+                return true;
+            }
+            default:
+                return fail(st, ParseErrorCode::InvalidEscape);
+            }
+        }
+
+        bool read_string(ParserState & st, std::string & res)
+        {
+            if (end_of_text(st) || (get_symbol(st) != Quote))
+                return fail(st, ParseErrorCode::UnexpectedToken);
             ++st.ptr;
 
-            std::string res;
+            if (st.options.trusted)
+            {
+                // strings without escape sequences are copied at once
+                auto begin = st.txt.data + st.ptr;
+                auto quote = static_cast<const char *>(std::memchr(begin, Quote, st.txt.size - st.ptr));
+                if ((quote != nullptr) && (std::memchr(begin, '\\', quote - begin) == nullptr))
+                {
+                    JCO_STATS(st.stats.allocations += (std::size_t(quote - begin) > res.capacity()));
+                    res.assign(begin, quote);
+                    st.ptr = quote - st.txt.data + 1;
+                    return true;
+                }
+            }
+
+            res.clear();
+            JCO_STATS(bool escaped = false);
 
             for (;;)
             {
                 if (end_of_text(st))
-                    throw ParseError();
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
 
                 auto c = get_symbol(st);
 
@@ -153,70 +289,178 @@ namespace jco
                 {
                 case Quote:
                     ++st.ptr;
-                    return res;
+                    JCO_STATS(st.stats.unescaped_strings += escaped);
+                    return true;
                 case '\\':
+                {
+                    JCO_STATS(escaped = true);
+                    // an escape appends up to 4 bytes
+                    JCO_STATS(auto capacity = res.capacity());
                     ++st.ptr;
-                    if (end_of_text(st))
-                        throw ParseError();
-                    c = get_symbol(st);
-                    switch (c)
+                    auto out = std::back_inserter(res);
+                    if (!read_escape(st, out))
+                        return false;
+                    JCO_STATS(st.stats.allocations += (res.capacity() != capacity));
+                    break;
+                }
+                default:
+                    JCO_STATS(st.stats.allocations += (res.size() == res.capacity()));
+                    res.push_back(c);
+                    ++st.ptr;
+                }
+            }
+        }
+
+        namespace
+        {
+            bool is_utf8_continuation(char c)
+            {
+                return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+            }
+
+            // Collects decoded text and hands it to the sink when full.
+            struct chunk_buffer
+            {
+                chunk_buffer(std::size_t capacity, chunk_sink const & sink, std::size_t & total)
+                    : capacity(capacity)
+                    , sink(sink)
+                    , total(total)
+                {
+                    // the memory of the thread is taken over while the value
+                    // is read, a sink parsing another chunked string gets
+                    // storage of its own
+                    storage.swap(spare_storage());
+                    storage.resize(capacity);
+                    data = storage.data();
+                }
+
+                ~chunk_buffer()
+                {
+                    spare_storage().swap(storage);
+                }
+
+                chunk_buffer(chunk_buffer const &) = delete;
+                chunk_buffer& operator = (chunk_buffer const &) = delete;
+
+                static std::vector<char> & spare_storage()
+                {
+                    thread_local std::vector<char> storage;
+                    return storage;
+                }
+
+                void flush()
+                {
+                    if (used == 0)
+                        return;
+                    if (sink)
+                        sink(boost::string_ref(data, used));
+                    total += used;
+                    used = 0;
+                }
+
+                // a decoded escape sequence, kept in a single chunk
+                void put_symbol(const char * s, std::size_t n)
+                {
+                    if (capacity - used < n)
+                        flush();
+                    std::memcpy(data + used, s, n);
+                    used += n;
+                }
+
+                // text without escapes, cut between UTF-8 sequences
+                void put_run(const char * s, std::size_t n)
+                {
+                    for (;;)
                     {
-                    case Quote:
-                    case '\\':
-                    case '/':
-                        res.push_back(c);
-                        ++st.ptr;
-                        break;
-                    case 'b':
-                        res.push_back(0x08);
-                        ++st.ptr;
-                        break;
-                    case 'f':
-                        res.push_back(0x0C);
-                        ++st.ptr;
-                        break;
-                    case 'n':
-                        res.push_back(SkipSymbol::LF);
-                        ++st.ptr;
-                        break;
-                    case 'r':
-                        res.push_back(SkipSymbol::CR);
-                        ++st.ptr;
-                        break;
-                    case 't':
-                        res.push_back(SkipSymbol::Tab);
-                        ++st.ptr;
-                        break;
-                    case 'u':
-                        ++st.ptr;
-                        if (st.ptr + 4 > st.txt.size)
-                            throw ParseError();
-                        auto utf16 = read_utf16_symbol(st);
-                        if ((utf16 < 0xD800) || (utf16 > 0xDFFF))
-                        {
-                            convert_to_utf8(utf16, std::back_inserter(res));
-                        }
-                        else
+                        auto room = capacity - used;
+                        if (n <= room)
                         {
-                            if ((st.ptr + 5 >= st.txt.size) || (get_symbol(st) != '\\') || (st.txt.data[st.ptr + 1] != 'u'))
-                                throw ParseError();
-                            st.ptr += 2;
-                            convert_to_utf8(utf16, read_utf16_symbol(st), std::back_inserter(res));
+                            std::memcpy(data + used, s, n);
+                            used += n;
+                            return;
                         }
-                        break;
+
+                        auto cut = room;
+                        for (int i = 0; (i != 3) && (cut != 0) && is_utf8_continuation(s[cut]); ++i)
+                            --cut;
+
+                        std::memcpy(data + used, s, cut);
+                        used += cut;
+                        s += cut;
+                        n -= cut;
+                        flush();
                     }
-                    break;
-                default:
-                    res.push_back(c);
+                }
+
+                std::vector<char>   storage;
+                char *              data;
+                std::size_t         capacity;
+                std::size_t         used = 0;
+                chunk_sink const &  sink;
+                std::size_t &       total;
+            };
+        }
+
+        bool read_string_chunks(ParserState & st, std::size_t chunk_size, chunk_sink const & sink, std::size_t & size)
+        {
+            if (end_of_text(st) || (get_symbol(st) != Quote))
+                return fail(st, ParseErrorCode::UnexpectedToken);
+            ++st.ptr;
+
+            size = 0;
+            // room for any decoded escape sequence
+            chunk_buffer buffer(std::max<std::size_t>(chunk_size, 8), sink, size);
+
+            for (;;)
+            {
+                auto begin = st.ptr;
+                while ((st.ptr != st.txt.size) && (st.txt.data[st.ptr] != Quote) && (st.txt.data[st.ptr] != '\\'))
+                    ++st.ptr;
+                buffer.put_run(st.txt.data + begin, st.ptr - begin);
+
+                if (end_of_text(st))
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
+
+                if (get_symbol(st) == Quote)
+                {
                     ++st.ptr;
+                    buffer.flush();
+                    return true;
                 }
+
+                ++st.ptr;
+                char symbol[8];
+                char * end = symbol;
+                if (!read_escape(st, end))
+                    return false;
+                buffer.put_symbol(symbol, end - symbol);
             }
         }
 
-        void skip_number(ParserState & st)
+        std::string read_string(ParserState & st)
         {
+            std::string res;
+            check(st, read_string(st, res));
+            return res;
+        }
+
+        bool is_number_symbol(char c)
+        {
+            return ((c >= '0') && (c <= '9')) || (c == '-') || (c == '+') || (c == '.') || (c == 'e') || (c == 'E');
+        }
+
+        bool skip_number(ParserState & st)
+        {
+            if (st.options.trusted)
+            {
+                while (!end_of_text(st) && is_number_symbol(get_symbol(st)))
+                    ++st.ptr;
+                return true;
+            }
+
             enum { INT_START, INT, FRAC_START, FRAC, EXP_START, EXP } state = INT_START;
 
+            std::size_t begin = st.ptr;
             for (;; ++st.ptr)
             {
                 if (st.ptr == st.txt.size)
@@ -234,9 +478,16 @@ namespace jco
                         state = EXP;
                         break;
                     default:
-                        throw ParseError();
+                        return fail(st, ParseErrorCode::InvalidNumber, begin);
                     }
                 }
+                else if (c == '+')
+                {
+                    if (state == EXP_START)
+                        state = EXP;
+                    else
+                        return fail(st, ParseErrorCode::InvalidNumber, begin);
+                }
                 else if ((c == 'e') || (c == 'E'))
                 {
                     switch (state)
@@ -246,7 +497,7 @@ namespace jco
                         state = EXP_START;
                         break;
                     default:
-                        throw ParseError();
+                        return fail(st, ParseErrorCode::InvalidNumber, begin);
                     }
                 }
                 else if (c == '.')
@@ -254,7 +505,7 @@ namespace jco
                     if (state == INT)
                         state = FRAC_START;
                     else
-                        throw ParseError();
+                        return fail(st, ParseErrorCode::InvalidNumber, begin);
                 }
                 else if (c >= '0' && c <= '9')
                 {
@@ -282,25 +533,183 @@ namespace jco
             case INT_START:
             case FRAC_START:
             case EXP_START:
-                throw ParseError();
+                return fail(st, ParseErrorCode::InvalidNumber, begin);
             default:
-                break;
+                return true;
             }
         }
 
-        void read_number(ParserState & st, double & out)
+        // Trusted input: a single pass over the number. Up to 2^53 significant
+        // digits and powers of 10 up to 22 are exact as doubles, so is their
+        // product or quotient (numbers written by jco are such), anything
+        // else goes to strtod.
+        bool read_number_trusted(ParserState & st, double & out)
         {
+            static const double powers_of_10[] = {
+                1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            const char * p = st.txt.data + st.ptr;
+            const char * end = st.txt.data + st.txt.size;
+
+            bool negative = (p != end) && (*p == '-');
+            if (negative)
+                ++p;
+
+            std::uint64_t mantissa = 0;
+            int digits = 0;
+            int exponent = 0;
+            bool exact = true;
+
+            auto digit = [&] (char c) {
+                // leading zeros aren't significant
+                if ((mantissa == 0) && (c == '0'))
+                    return;
+                if (digits == 19)
+                    exact = false;
+                else
+                    mantissa = mantissa * 10 + (c - '0');
+                ++digits;
+            };
+
+            for (; (p != end) && (*p >= '0') && (*p <= '9'); ++p)
+                digit(*p);
+            if ((p != end) && (*p == '.'))
+            {
+                for (++p; (p != end) && (*p >= '0') && (*p <= '9'); ++p)
+                {
+                    digit(*p);
+                    --exponent;
+                }
+            }
+            if ((p != end) && ((*p == 'e') || (*p == 'E')))
+            {
+                ++p;
+                bool negative_exponent = (p != end) && (*p == '-');
+                if ((p != end) && ((*p == '-') || (*p == '+')))
+                    ++p;
+                int e = 0;
+                for (; (p != end) && (*p >= '0') && (*p <= '9'); ++p)
+                {
+                    if (e < 10000)
+                        e = e * 10 + (*p - '0');
+                }
+                exponent += negative_exponent ? -e : e;
+            }
+
+            if (!exact || (mantissa > (std::uint64_t(1) << 53)) || (exponent < -22) || (exponent > 22))
+                return false;
+
+            double x = static_cast<double>(mantissa);
+            x = (exponent < 0) ? x / powers_of_10[-exponent] : x * powers_of_10[exponent];
+            out = negative ? -x : x;
+            st.ptr = p - st.txt.data;
+            return true;
+        }
+
+        bool read_number(ParserState & st, double & out)
+        {
+            if (st.options.trusted && read_number_trusted(st, out))
+                return true;
+
             std::size_t begin = st.ptr;
-            skip_number(st);
-            out = std::stod(std::string(reinterpret_cast<const char *>(st.txt.data + begin), st.ptr - begin));
+            if (!skip_number(st))
+                return false;
+
+            // strtod needs a terminating zero, numbers are copied to the stack
+            char buf[64];
+            std::size_t size = st.ptr - begin;
+            if (size < sizeof(buf))
+            {
+                std::memcpy(buf, st.txt.data + begin, size);
+                buf[size] = 0;
+                out = std::strtod(buf, nullptr);
+            }
+            else
+            {
+                JCO_STATS(++st.stats.allocations);
+                out = std::strtod(std::string(st.txt.data + begin, size).c_str(), nullptr);
+            }
+            return true;
+        }
+
+        bool read_integer(ParserState & st, bool & negative, std::uint64_t & magnitude)
+        {
+            std::size_t begin = st.ptr;
+            negative = !end_of_text(st) && (get_symbol(st) == '-');
+            if (negative)
+                ++st.ptr;
+
+            std::size_t digits = st.ptr;
+            bool overflow = false;
+            magnitude = 0;
+            for (; !end_of_text(st); ++st.ptr)
+            {
+                unsigned digit = static_cast<unsigned char>(get_symbol(st)) - '0';
+                if (digit > 9)
+                    break;
+                overflow |= (magnitude > (UINT64_MAX - digit) / 10);
+                magnitude = magnitude * 10 + digit;
+            }
+
+            if (st.ptr == digits)
+                return fail(st, ParseErrorCode::InvalidNumber, begin);
+            if (!end_of_text(st))
+            {
+                auto c = get_symbol(st);
+                if ((c == '.') || (c == 'e') || (c == 'E'))
+                    return fail(st, ParseErrorCode::InvalidNumber, begin);
+            }
+            if (overflow)
+                return fail(st, ParseErrorCode::NumberOutOfRange, begin);
+            return true;
         }
 
-        void skip_string(ParserState & st)
+        std::size_t count_elements(ParserState const & st)
+        {
+            // commas up to the first closing bracket, there are no strings
+            // or nested containers in arrays of numbers
+            const char * const begin = st.txt.data + st.ptr;
+            const char * p = begin;
+            const char * end = st.txt.data + st.txt.size;
+            std::size_t commas = 0;
+
+            // every element takes at least a digit and a comma, so runs of
+            // commas in broken input don't reserve more than a valid array
+            auto count = [begin] (const char * close, std::size_t commas) {
+                return std::min(commas + 1, std::size_t(close - begin) / 2 + 1);
+            };
+
+#ifdef __SSE2__
+            const __m128i comma = _mm_set1_epi8(',');
+            const __m128i close = _mm_set1_epi8(']');
+            for (; end - p >= 16; p += 16)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+                unsigned commas_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, comma));
+                unsigned close_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, close));
+                if (close_mask != 0)
+                {
+                    // only the commas before the bracket
+                    commas_mask &= (close_mask & (0u - close_mask)) - 1;
+                    return count(p + __builtin_ctz(close_mask), commas + __builtin_popcount(commas_mask));
+                }
+                commas += __builtin_popcount(commas_mask);
+            }
+#endif
+
+            for (; (p != end) && (*p != ']'); ++p)
+                commas += (*p == ',');
+            return count(p, commas);
+        }
+
+        bool skip_string(ParserState & st)
         {
             for (;;)
             {
                 if (end_of_text(st))
-                    throw ParseError();
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
 
                 auto c = get_symbol(st);
 
@@ -308,11 +717,11 @@ namespace jco
                 {
                 case Quote:
                     ++st.ptr;
-                    return;
+                    return true;
                 case '\\':
                     ++st.ptr;
                     if (end_of_text(st))
-                        throw ParseError();
+                        return fail(st, ParseErrorCode::UnexpectedEnd);
                     c = get_symbol(st);
                     switch (c)
                     {
@@ -327,18 +736,24 @@ namespace jco
                         ++st.ptr;
                         break;
                     case 'u':
+                    {
                         ++st.ptr;
                         if (st.ptr + 4 > st.txt.size)
-                            throw ParseError();
-                        auto utf16 = read_utf16_symbol(st);
+                            return fail(st, ParseErrorCode::UnexpectedEnd);
+                        std::uint16_t utf16;
+                        if (!read_utf16_symbol(st, utf16))
+                            return false;
                         if ((utf16 >= 0xD800) && (utf16 <= 0xDFFF))
                         {
                             if ((st.ptr + 5 >= st.txt.size) || (get_symbol(st) != '\\') || (st.txt.data[st.ptr + 1] != 'u'))
-                                throw ParseError();
+                                return fail(st, ParseErrorCode::InvalidEscape);
                             st.ptr += 6;
                         }
                         break;
                     }
+                    default:
+                        return fail(st, ParseErrorCode::InvalidEscape);
+                    }
                     break;
                 default:
                     ++st.ptr;
@@ -346,89 +761,397 @@ namespace jco
             }
         }
 
-        void skip_object(ParserState & st)
+        bool skip_constant(ParserState & st)
         {
+            static const boost::string_ref constants[] = { "true", "false", "null" };
+
+            // the first letter is already consumed by next_token
+            --st.ptr;
+            for (auto c : constants)
+            {
+                if ((st.txt.size - st.ptr >= c.size()) && std::equal(c.begin(), c.end(), st.txt.data + st.ptr))
+                {
+                    st.ptr += c.size();
+                    return true;
+                }
+            }
+            return fail(st, ParseErrorCode::InvalidConstant);
+        }
+
+        // Kinds of open containers, a bit per level: set for objects, clear
+        // for arrays. The first 256 levels don't allocate.
+        class bit_stack
+        {
+        public:
+            bool empty() const          { return size_ == 0; }
+            std::size_t size() const    { return size_; }
+
+            bool top() const
+            {
+                auto i = size_ - 1;
+                return (word(i / 64) >> (i % 64)) & 1;
+            }
+
+            void push(bool bit)
+            {
+                auto w = size_ / 64;
+                if ((w >= inline_words) && (w - inline_words == more_.size()))
+                    more_.push_back(0);
+
+                std::uint64_t mask = std::uint64_t(1) << (size_ % 64);
+                auto & dest = word(w);
+                dest = bit ? (dest | mask) : (dest & ~mask);
+                ++size_;
+            }
+
+            void pop()
+            {
+                --size_;
+            }
+
+        private:
+            std::uint64_t & word(std::size_t w)
+            {
+                return (w < inline_words) ? inline_[w] : more_[w - inline_words];
+            }
+
+            std::uint64_t word(std::size_t w) const
+            {
+                return (w < inline_words) ? inline_[w] : more_[w - inline_words];
+            }
+
+        private:
+            static const std::size_t    inline_words = 4;
+            std::uint64_t               inline_[inline_words];
+            std::vector<std::uint64_t>  more_;
+            std::size_t                 size_ = 0;
+        };
+
+        // "key" :
+        bool skip_key(ParserState & st)
+        {
+            auto token = next_token(st);
+            if (token != Token::Quote)
+                return unexpected(st, token);
+            if (!skip_string(st))
+                return false;
+            token = next_token(st);
+            if (token != Token::Colon)
+                return unexpected(st, token);
+            return true;
+        }
+
+        // A loop over tokens with containers on a bit stack, so neither deep
+        // nor large values take the call stack.
+        bool skip_value_impl(ParserState & st)
+        {
+            auto max_depth = st.options.max_depth;
+            std::size_t limit = (max_depth > st.depth) ? max_depth - st.depth : 0;
+
+            bit_stack stack;
             for (;;)
             {
-                switch (next_token(st))
+                // a value starts
+                auto token = next_token(st);
+                switch (token)
                 {
-                case Token::ObjEnd:
-                    return;
+                case Token::ObjBegin:
+                case Token::ArrBegin:
+                {
+                    bool is_object = (token == Token::ObjBegin);
+                    auto begin = st.ptr - 1;
+                    token = next_token(st);
+                    if (token == (is_object ? Token::ObjEnd : Token::ArrEnd))
+                        break;
+                    if ((token == Token::EOT) || (token == Token::Error))
+                        return unexpected(st, token);
+
+                    if (stack.size() == limit)
+                        return fail(st, ParseErrorCode::TooDeep, begin);
+                    stack.push(is_object);
+                    JCO_STATS(st.stats.max_depth = std::max(st.stats.max_depth, st.depth + stack.size()));
+
+                    // the token is the first one of the key or of the element
+                    --st.ptr;
+                    if (is_object && !skip_key(st))
+                        return false;
+                    continue;
+                }
                 case Token::Quote:
-                    skip_string(st);
-                    if (next_token(st) != Token::Colon)
-                        throw ParseError();
-                    skip_value(st);
+                    if (!skip_string(st))
+                        return false;
+                    break;
+                case Token::Number:
+                    --st.ptr;
+                    if (!skip_number(st))
+                        return false;
+                    break;
+                case Token::Constant:
+                    if (!skip_constant(st))
+                        return false;
+                    break;
+                default:
+                    return unexpected(st, token);
+                }
+
+                // the value is complete, finished containers are closed up to
+                // the next member or element
+                for (;;)
+                {
+                    if (stack.empty())
+                        return true;
 
-                    switch (next_token(st))
+                    token = next_token(st);
+                    if (token == Token::Comma)
                     {
-                    case Token::ObjEnd:
-                        return;
-                    case Token::Comma:
+                        if (stack.top() && !skip_key(st))
+                            return false;
                         break;
-                    default:
-                        throw ParseError();
                     }
-                    break;
-                default:
-                    throw ParseError();
+                    if (token != (stack.top() ? Token::ObjEnd : Token::ArrEnd))
+                        return unexpected(st, token);
+                    stack.pop();
                 }
             }
         }
 
-        void skip_array(ParserState & st)
+        // the opening quote is consumed
+        bool skip_string_trusted(ParserState & st)
         {
             for (;;)
             {
-                switch (next_token(st))
+                auto begin = st.txt.data + st.ptr;
+                auto quote = static_cast<const char *>(std::memchr(begin, Quote, st.txt.size - st.ptr));
+                if (quote == nullptr)
                 {
-                case Token::ArrEnd:
-                    return;
-                case Token::EOT:
-                case Token::ObjEnd:
-                    throw ParseError();
-                default:
-                    --st.ptr;
-                    skip_value(st);
+                    st.ptr = st.txt.size;
+                    return fail(st, ParseErrorCode::UnexpectedEnd);
+                }
+
+                // a quote after an odd number of backslashes is escaped
+                std::size_t backslashes = 0;
+                for (auto p = quote; (p != begin) && (p[-1] == '\\'); --p)
+                    ++backslashes;
+
+                st.ptr = quote - st.txt.data + 1;
+                if (backslashes % 2 == 0)
+                    return true;
+            }
+        }
+
+        // Trusted input: only strings and brackets are looked at, to find the
+        // end of the value.
+        bool skip_value_trusted(ParserState & st)
+        {
+            if (end_of_text(st) || (skip_spaces(st) == SSStatus::EOT))
+                return fail(st, ParseErrorCode::UnexpectedEnd);
 
-                    switch (next_token(st))
+            std::size_t depth = 0;
+            while (!end_of_text(st))
+            {
+                switch (st.txt.data[st.ptr++])
+                {
+                case Quote:
+                    if (!skip_string_trusted(st))
+                        return false;
+                    break;
+                case '{':
+                case '[':
+                    ++depth;
+                    break;
+                case '}':
+                case ']':
+                    if (depth == 0)
+                        return fail(st, ParseErrorCode::UnexpectedToken, st.ptr - 1);
+                    --depth;
+                    break;
+                default:
+                    // a number or a constant
+                    if (depth == 0)
                     {
-                    case Token::ArrEnd:
-                        return;
-                    case Token::Comma:
-                        break;
-                    default:
-                        throw ParseError();
+                        for (; !end_of_text(st); ++st.ptr)
+                        {
+                            auto c = get_symbol(st);
+                            if (is_skip_symbol(c) || (c == ',') || (c == '}') || (c == ']'))
+                                break;
+                        }
                     }
                 }
+
+                if (depth == 0)
+                    return true;
             }
+            return fail(st, ParseErrorCode::UnexpectedEnd);
         }
 
-        void skip_value(ParserState & st)
+        bool read_string_ref(ParserState & st, std::string & buffer, boost::string_ref & str)
         {
-            switch(next_token(st))
+            if (end_of_text(st) || (get_symbol(st) != Quote))
+                return fail(st, ParseErrorCode::UnexpectedToken);
+
+            auto begin = st.ptr + 1;
+            for (auto i = begin; i != st.txt.size; ++i)
             {
-            case Token::ObjBegin:
-                skip_object(st);
-                break;
-            case Token::ArrBegin:
-                skip_array(st);
-                break;
-            case Token::Quote:
-                skip_string(st);
-                break;
-            case Token::Number:
-                --st.ptr;
-                skip_number(st);
-                break;
-            default:
-                throw ParseError();
+                char c = st.txt.data[i];
+                if (c == Quote)
+                {
+                    st.ptr = i + 1;
+                    str = boost::string_ref(st.txt.data + begin, i - begin);
+                    return true;
+                }
+                if (c == '\\')
+                    break;
+            }
+            if (!read_string(st, buffer))
+                return false;
+            str = buffer;
+            return true;
+        }
+
+        std::size_t find_field(boost::string_ref const * names, std::size_t count, boost::string_ref key)
+        {
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                if (names[i] == key)
+                    return i;
+            }
+            return count;
+        }
+
+        bool skip_value(ParserState & st)
+        {
+            JCO_STATS(auto begin = st.ptr);
+            if (!(st.options.trusted ? skip_value_trusted(st) : skip_value_impl(st)))
+                return false;
+            JCO_STATS(++st.stats.values_skipped);
+            JCO_STATS(st.stats.bytes_skipped += st.ptr - begin);
+            return true;
+        }
+
+        bool parse_field(ParserState & st, void * value, field_descriptor const & field)
+        {
+            switch (field.type)
+            {
+            case field_type::Double:    return read_number(st, *static_cast<double *>(value));
+            case field_type::Float:     return parse(st, *static_cast<float *>(value));
+            case field_type::Int32:     return parse(st, *static_cast<std::int32_t *>(value));
+            case field_type::Int64:     return parse(st, *static_cast<std::int64_t *>(value));
+            case field_type::UInt32:    return parse(st, *static_cast<std::uint32_t *>(value));
+            case field_type::UInt64:    return parse(st, *static_cast<std::uint64_t *>(value));
+            case field_type::String:    return read_string(st, *static_cast<std::string *>(value));
+            case field_type::Other:     break;
             }
+            return field.ops->parse(st, value);
         }
+
+        void clear_field(void * value, field_descriptor const & field)
+        {
+            switch (field.type)
+            {
+            case field_type::Double:    *static_cast<double *>(value) = 0;          return;
+            case field_type::Float:     *static_cast<float *>(value) = 0;           return;
+            case field_type::Int32:     *static_cast<std::int32_t *>(value) = 0;    return;
+            case field_type::Int64:     *static_cast<std::int64_t *>(value) = 0;    return;
+            case field_type::UInt32:    *static_cast<std::uint32_t *>(value) = 0;   return;
+            case field_type::UInt64:    *static_cast<std::uint64_t *>(value) = 0;   return;
+            case field_type::String:    static_cast<std::string *>(value)->clear(); return;
+            case field_type::Other:     break;
+            }
+            field.ops->clear(value);
+        }
+
+        bool parse_fields(ParserState & st, void * object, field_descriptor const * fields, std::size_t count)
+        {
+            auto base = static_cast<char *>(object);
+
+            // fields seen in the input, on the stack unless there are lots of them
+            const std::size_t inline_count = 256;
+            std::bitset<inline_count> seen_inline;
+            std::vector<bool> seen_more((count > inline_count) ? count : 0);
+            auto seen = [&] (std::size_t i) {
+                return (count > inline_count) ? bool(seen_more[i]) : seen_inline.test(i);
+            };
+
+            // the same guess as for compiled objects: the field after the last matched one
+            std::size_t expected = 0;
+
+            bool ok = parse_members(st, [&] (boost::string_ref key) {
+                auto index = expected;
+                if ((index >= count) || (fields[index].name != key))
+                {
+                    for (index = 0; (index != count) && (fields[index].name != key); ++index)
+                        ;
+                    if (index == count)
+                    {
+                        JCO_STATS(++st.stats.unmatched_keys);
+                        return skip_value(st);
+                    }
+                }
+
+                if (count > inline_count)
+                    seen_more[index] = true;
+                else
+                    seen_inline.set(index);
+                expected = index + 1;
+                return parse_field(st, base + fields[index].offset, fields[index]);
+            });
+            if (!ok)
+                return false;
+
+            for (std::size_t i = 0; i != count; ++i)
+            {
+                if (seen(i))
+                    continue;
+                if (st.options.require_all_fields)
+                {
+                    st.status.field = fields[i].name;
+                    return fail(st, ParseErrorCode::MissingField);
+                }
+                clear_field(base + fields[i].offset, fields[i]);
+            }
+            return true;
+        }
+
+        void clear_fields(void * object, field_descriptor const * fields, std::size_t count)
+        {
+            auto base = static_cast<char *>(object);
+            for (std::size_t i = 0; i != count; ++i)
+                clear_field(base + fields[i].offset, fields[i]);
+        }
+
+        void throw_error(ParseStatus const & status)
+        {
+            if (status.code == ParseErrorCode::MissingField)
+                throw MissingFieldError(status.field.to_string(), status.offset);
+            throw ParseError(status.code, status.offset);
+        }
+    }
+
+    const char * ParseError::what() const noexcept
+    {
+        switch (code)
+        {
+        case ParseErrorCode::None:              return "jco: no error";
+        case ParseErrorCode::UnexpectedEnd:     return "jco: unexpected end of text";
+        case ParseErrorCode::InvalidSymbol:     return "jco: invalid symbol";
+        case ParseErrorCode::UnexpectedToken:   return "jco: unexpected token";
+        case ParseErrorCode::InvalidNumber:     return "jco: invalid number";
+        case ParseErrorCode::NumberOutOfRange:  return "jco: number is out of range";
+        case ParseErrorCode::InvalidEscape:     return "jco: invalid escape sequence";
+        case ParseErrorCode::InvalidConstant:   return "jco: invalid constant";
+        case ParseErrorCode::InvalidUtf8:       return "jco: invalid UTF-8";
+        case ParseErrorCode::InvalidBase64:     return "jco: invalid base64";
+        case ParseErrorCode::UnknownEnumValue:  return "jco: unknown enum value";
+        case ParseErrorCode::UnknownType:       return "jco: unknown type";
+        case ParseErrorCode::TooDeep:           return "jco: nesting is too deep";
+        case ParseErrorCode::MissingField:      return "jco: missing field";
+        case ParseErrorCode::TrailingData:      return "jco: data after the end of the document";
+        }
+        return "jco: parse error";
     }
 
-    Parser::Parser(utf8_text const & txt)
-        : st_{ txt, 0 }
+    Parser::Parser(utf8_text const & txt, ParseOptions const & options)
+        : st_{ txt, 0, options }
     {
         details::skip_BOM(st_);
     }
@@ -438,31 +1161,56 @@ namespace jco
         return details::end_of_text(st_) || (details::skip_spaces(st_) == details::SSStatus::EOT);
     }
 
+    void Parser::expect_eot()
+    {
+        details::check(st_, details::expect_eot(st_));
+    }
+
     std::string Parser::parse_string()
     {
         using namespace details;
 
-        if (skip_spaces(st_) != SSStatus::Normal)
-            throw ParseError();
+        if ((skip_spaces(st_) != SSStatus::Normal) || (get_symbol(st_) != Quote))
+            throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, st_.ptr));
 
         return read_string(st_);
     }
 
     details::Token Parser::next_token()
     {
-        return details::next_token(st_);
+        auto token = details::next_token(st_);
+        if (token == details::Token::Error)
+            details::throw_error(st_.status);
+        return token;
+    }
+
+    void Parser::skip_value()
+    {
+        details::check(st_, details::skip_value(st_));
+    }
+
+    boost::string_ref Parser::raw_value()
+    {
+        if (!details::end_of_text(st_))
+            details::skip_spaces(st_);
+
+        auto begin = st_.ptr;
+        skip_value();
+        return boost::string_ref(st_.txt.data + begin, st_.ptr - begin);
     }
 
     void Parser::expect(details::Token expected)
     {
+        auto begin = st_.ptr;
         auto real = next_token();
         if (real != expected)
-            throw ParseError();
+            details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, begin));
     }
 
     void Parser::expect(boost::string_ref str)
     {
+        auto begin = st_.ptr;
         if (parse_string() != str)
-            throw ParseError();
+            details::throw_error(ParseStatus(ParseErrorCode::UnexpectedToken, begin));
     }
 }
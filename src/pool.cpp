@@ -0,0 +1,98 @@
+#include "jco/pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <exception>
+
+namespace jco
+{
+    namespace details
+    {
+        namespace
+        {
+            const std::size_t first_block_slots = 16;
+            const std::size_t max_block_slots   = 4096;
+        }
+
+        slab::slab(std::size_t size, std::size_t align)
+            // a released slot keeps a pointer to the next one
+            : slot_size_((std::max(size, sizeof(free_slot)) + align - 1) / align * align)
+            , block_slots_(first_block_slots)
+        {}
+
+        slab::~slab()
+        {
+            assert(used_ == 0);
+            for (void * block : blocks_)
+                ::operator delete(block);
+        }
+
+        void * slab::allocate()
+        {
+            ++used_;
+            if (free_)
+            {
+                auto slot = free_;
+                free_ = free_->next;
+                return slot;
+            }
+
+            if (next_ == end_)
+            {
+                auto size = slot_size_ * block_slots_;
+                next_ = static_cast<char *>(::operator new(size));
+                end_ = next_ + size;
+                blocks_.push_back(next_);
+                block_slots_ = std::min(block_slots_ * 2, max_block_slots);
+            }
+
+            auto slot = next_;
+            next_ += slot_size_;
+            return slot;
+        }
+
+        void slab::release(void * slot)
+        {
+            --used_;
+            free_ = new (slot) free_slot{ free_ };
+        }
+    }
+
+    ParseContext::ParseContext()
+        : last_type_(typeid(void))
+        , last_slab_(nullptr)
+    {}
+
+    ParseContext::~ParseContext()
+    {
+        auto alive = used();
+        if (alive != 0)
+        {
+            std::fprintf(stderr, "jco: ParseContext destroyed with %zu pooled objects alive\n", alive);
+            std::terminate();
+        }
+    }
+
+    std::size_t ParseContext::used() const
+    {
+        std::size_t res = 0;
+        for (auto const & s : slabs_)
+            res += s.second->used();
+        return res;
+    }
+
+    details::slab & ParseContext::slab_for(std::type_index type, std::size_t size, std::size_t align)
+    {
+        if (last_slab_ && (last_type_ == type))
+            return *last_slab_;
+
+        auto & s = slabs_[type];
+        if (!s)
+            s.reset(new details::slab(size, align));
+
+        last_type_ = type;
+        last_slab_ = s.get();
+        return *s;
+    }
+}
@@ -25,9 +25,16 @@ namespace jco
 
             void print(boost::string_ref)   override;
             void print(double)              override;
+            void print(long long)           override;
+            void print(unsigned long long)  override;
+            void print(fixed_tag)           override;
+            void print(base64_tag)          override;
+            void print(raw_tag)             override;
             void print(bool)                override;
             void print(std::nullptr_t)      override;
 
+            PrinterPtr clone(std::ostream & backend) const override;
+
         private:
             void print_indents();
             void pre_print_value();
@@ -112,6 +119,36 @@ namespace jco
             PrinterBase::print(x);
         }
 
+        void PrettyPrinter::print(long long x)
+        {
+            pre_print_value();
+            PrinterBase::print(x);
+        }
+
+        void PrettyPrinter::print(unsigned long long x)
+        {
+            pre_print_value();
+            PrinterBase::print(x);
+        }
+
+        void PrettyPrinter::print(fixed_tag x)
+        {
+            pre_print_value();
+            PrinterBase::print(x);
+        }
+
+        void PrettyPrinter::print(base64_tag x)
+        {
+            pre_print_value();
+            PrinterBase::print(x);
+        }
+
+        void PrettyPrinter::print(raw_tag x)
+        {
+            pre_print_value();
+            PrinterBase::print(x);
+        }
+
         void PrettyPrinter::print(bool f)
         {
             pre_print_value();
@@ -124,6 +161,13 @@ namespace jco
             PrinterBase::print(nullptr);
         }
 
+        PrinterPtr PrettyPrinter::clone(std::ostream & backend) const
+        {
+            std::unique_ptr<PrettyPrinter> res(new PrettyPrinter(backend));
+            res->indents_num_ = indents_num_;
+            return PrinterPtr(res.release());
+        }
+
         PrinterPtr make_pretty_printer(std::ostream & backend)
         {
             return PrinterPtr(new PrettyPrinter(backend));
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <ostream>
 #include <boost/utility/string_ref.hpp>
 
+#include "jco/serialization.h"
+
 namespace jco
 {
     namespace serialization
@@ -11,6 +14,11 @@ namespace jco
         {
             virtual void print(boost::string_ref)   = 0;
             virtual void print(double)              = 0;
+            virtual void print(long long)           = 0;
+            virtual void print(unsigned long long)  = 0;
+            virtual void print(fixed_tag)           = 0;
+            virtual void print(base64_tag)          = 0;
+            virtual void print(raw_tag)             = 0;
             virtual void print(bool)                = 0;
             virtual void print(std::nullptr_t)      = 0;
 
@@ -23,6 +31,12 @@ namespace jco
             virtual void key(boost::string_ref)     = 0;
             virtual void separate_object_fields()   = 0;
 
+            // already serialized text, written as is
+            virtual void raw(boost::string_ref)     = 0;
+
+            // printer of the same style and indentation writing to another backend
+            virtual std::unique_ptr<Printer> clone(std::ostream & backend) const = 0;
+
             virtual ~Printer() {}
         };
 
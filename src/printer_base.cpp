@@ -1,9 +1,38 @@
 #include "printer_base.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "jco/base64.h"
+
 namespace jco
 {
     namespace serialization
     {
+        namespace
+        {
+            // Writes the digits backwards ending at end, returns the first one.
+            char * format_digits(unsigned long long x, char * end)
+            {
+                do
+                {
+                    *--end = static_cast<char>('0' + x % 10);
+                    x /= 10;
+                }
+                while (x != 0);
+                return end;
+            }
+
+            const unsigned max_fixed_digits = 18;
+
+            const unsigned long long powers_of_10[max_fixed_digits + 1] = {
+                1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+                100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+                10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+                100000000000000000ull, 1000000000000000000ull
+            };
+        }
+
         void PrinterBase::print(boost::string_ref str)
         {
             backend_ << "\"";
@@ -57,11 +86,96 @@ namespace jco
             backend_ << x;
         }
 
+        void PrinterBase::print(long long x)
+        {
+            char buf[24];
+            char * end = buf + sizeof(buf);
+            auto magnitude = (x < 0) ? 0ull - static_cast<unsigned long long>(x) : static_cast<unsigned long long>(x);
+            char * begin = format_digits(magnitude, end);
+            if (x < 0)
+                *--begin = '-';
+            backend_.write(begin, end - begin);
+        }
+
+        void PrinterBase::print(unsigned long long x)
+        {
+            char buf[24];
+            char * end = buf + sizeof(buf);
+            char * begin = format_digits(x, end);
+            backend_.write(begin, end - begin);
+        }
+
+        void PrinterBase::print(fixed_tag x)
+        {
+            unsigned digits = std::min(x.digits, max_fixed_digits);
+            double scaled = std::fabs(x.value) * powers_of_10[digits];
+
+            // numbers too large for 63 bits after scaling (and NaN or
+            // infinity) are left to the stream
+            if (!(scaled < 9.2e18))
+            {
+                print(x.value);
+                return;
+            }
+
+            auto rounded = static_cast<unsigned long long>(scaled + 0.5);
+
+            char buf[48];
+            char * end = buf + sizeof(buf);
+            char * begin = end;
+
+            auto integer = rounded;
+            if (digits != 0)
+            {
+                auto fraction = rounded % powers_of_10[digits];
+                integer = rounded / powers_of_10[digits];
+                for (unsigned i = 0; i != digits; ++i)
+                {
+                    *--begin = static_cast<char>('0' + fraction % 10);
+                    fraction /= 10;
+                }
+                *--begin = '.';
+            }
+            begin = format_digits(integer, begin);
+
+            // no "-0.00" for small negative numbers
+            if ((x.value < 0) && (rounded != 0))
+                *--begin = '-';
+
+            backend_.write(begin, end - begin);
+        }
+
+        void PrinterBase::print(base64_tag x)
+        {
+            // whole groups of 3 bytes per chunk, so only the last one is padded
+            const std::size_t chunk = 768;
+            char buf[chunk / 3 * 4];
+
+            auto data = static_cast<std::uint8_t const *>(x.data);
+            backend_ << "\"";
+            for (std::size_t i = 0; i < x.size; i += chunk)
+            {
+                auto size = jco::details::base64_encode(data + i, std::min(chunk, x.size - i), buf);
+                backend_.write(buf, size);
+            }
+            backend_ << "\"";
+        }
+
         void PrinterBase::print(std::nullptr_t)
         {
             backend_ << "null";
         }
 
+        void PrinterBase::print(raw_tag x)
+        {
+            raw(x.text);
+        }
+
+        void PrinterBase::raw(boost::string_ref str)
+        {
+            backend_.write(str.data(), str.size());
+        }
+
         PrinterBase::PrinterBase(std::ostream & backend)
             : backend_(backend)
         {}
@@ -8,9 +8,16 @@ namespace jco
         {
             void print(boost::string_ref)   override;
             void print(double)              override;
+            void print(long long)           override;
+            void print(unsigned long long)  override;
+            void print(fixed_tag)           override;
+            void print(base64_tag)          override;
+            void print(raw_tag)             override;
             void print(bool)                override;
             void print(std::nullptr_t)      override;
 
+            void raw(boost::string_ref)     override;
+
             explicit PrinterBase(std::ostream & backend);
 
         private:
@@ -1,6 +1,7 @@
 #include "jco/serialization.h"
 
 #include <cassert>
+#include <exception>
 
 namespace jco
 {
@@ -12,9 +13,12 @@ namespace jco
             out_.open_array();
         }
 
+        // While an exception propagates the value is abandoned unclosed,
+        // closing it would throw again; out_stream::reset() starts anew.
         array_scope::~array_scope()
         {
-            out_.close_array();
+            if (!std::uncaught_exception())
+                out_.close_array();
         }
 
         object_scope::object_scope(out_stream & out)
@@ -25,7 +29,8 @@ namespace jco
 
         object_scope::~object_scope()
         {
-            out_.close_object();
+            if (!std::uncaught_exception())
+                out_.close_object();
         }
 
         key_tag key(boost::string_ref name)
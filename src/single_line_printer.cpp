@@ -20,6 +20,8 @@ namespace jco
             void key(boost::string_ref)     override;
             void separate_object_fields()   override;
 
+            PrinterPtr clone(std::ostream & backend) const override;
+
         private:
             std::ostream & backend_;
         };
@@ -60,6 +62,11 @@ namespace jco
             backend_ << " : ";
         }
 
+        PrinterPtr SingleLinePrinter::clone(std::ostream & backend) const
+        {
+            return PrinterPtr(new SingleLinePrinter(backend));
+        }
+
         PrinterPtr make_single_line_printer(std::ostream & backend)
         {
             return PrinterPtr(new SingleLinePrinter(backend));
@@ -0,0 +1,402 @@
+#include "jco/validate.h"
+
+#include <algorithm>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace jco
+{
+    namespace
+    {
+        bool is_space(char c)
+        {
+            return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t');
+        }
+
+        bool is_digit(char c)
+        {
+            return (c >= '0') && (c <= '9');
+        }
+
+        // Symbols of a string that need no checks: ASCII, not a control one,
+        // neither a quote nor a backslash.
+        bool is_plain(unsigned char c)
+        {
+            return (c >= 0x20) && (c < 0x80) && (c != '"') && (c != '\\');
+        }
+
+        const char * skip_plain(const char * p, const char * end)
+        {
+#ifdef __SSE2__
+            // 16 symbols at a time; a signed comparison with 0x20 catches both
+            // control symbols and bytes of multibyte sequences
+            const __m128i quote     = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i space     = _mm_set1_epi8(0x20);
+            while (end - p >= 16)
+            {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+                                               _mm_cmplt_epi8(v, space));
+                int mask = _mm_movemask_epi8(special);
+                if (mask)
+                    return p + __builtin_ctz(mask);
+                p += 16;
+            }
+#endif
+            while ((p != end) && is_plain(static_cast<unsigned char>(*p)))
+                ++p;
+            return p;
+        }
+
+        bool is_continuation(const char * p, const char * end)
+        {
+            return (p != end) && ((static_cast<unsigned char>(*p) & 0xC0) == 0x80);
+        }
+
+        // Length of a well-formed UTF-8 sequence of two or more bytes (Unicode, table 3-7),
+        // zero if it's malformed, overlong or encodes a surrogate.
+        std::size_t utf8_sequence(const char * p, const char * end)
+        {
+            auto c = static_cast<unsigned char>(p[0]);
+
+            std::size_t size;
+            unsigned char min = 0x80, max = 0xBF;
+            if ((c >= 0xC2) && (c <= 0xDF))
+                size = 2;
+            else if ((c >= 0xE0) && (c <= 0xEF))
+            {
+                size = 3;
+                if (c == 0xE0)
+                    min = 0xA0;
+                else if (c == 0xED)
+                    max = 0x9F;
+            }
+            else if ((c >= 0xF0) && (c <= 0xF4))
+            {
+                size = 4;
+                if (c == 0xF0)
+                    min = 0x90;
+                else if (c == 0xF4)
+                    max = 0x8F;
+            }
+            else
+                return 0;
+
+            if ((static_cast<std::size_t>(end - p) < size))
+                return 0;
+
+            auto second = static_cast<unsigned char>(p[1]);
+            if ((second < min) || (second > max))
+                return 0;
+            for (std::size_t i = 2; i != size; ++i)
+            {
+                if (!is_continuation(p + i, end))
+                    return 0;
+            }
+            return size;
+        }
+
+        // Containers are kept on an explicit stack, so deep documents don't
+        // exhaust the call stack.
+        struct Validator
+        {
+            Validator(utf8_text const & txt)
+                : begin(txt.data)
+                , p(txt.data)
+                , end(txt.data + txt.size)
+            {}
+
+            bool fail(ParseErrorCode code, const char * at)
+            {
+                status = ParseStatus(code, at - begin);
+                return false;
+            }
+
+            bool fail(ParseErrorCode code)
+            {
+                return fail(code, p);
+            }
+
+            void skip_spaces()
+            {
+                while ((p != end) && is_space(*p))
+                    ++p;
+            }
+
+            bool run()
+            {
+                if ((end - p >= 3) && (p[0] == '\xEF') && (p[1] == '\xBB') && (p[2] == '\xBF'))
+                    p += 3;
+
+                for (;;)
+                {
+                    auto depth = stack.size();
+                    if (!value())
+                        return false;
+                    // a non-empty container was opened, its first element follows
+                    if (stack.size() > depth)
+                        continue;
+
+                    // closes finished containers up to the next element
+                    for (;;)
+                    {
+                        skip_spaces();
+                        if (stack.empty())
+                            return (p == end) || fail(ParseErrorCode::TrailingData);
+                        if (p == end)
+                            return fail(ParseErrorCode::UnexpectedEnd);
+
+                        char c = *p;
+                        if (c == ',')
+                        {
+                            ++p;
+                            if ((stack.back() == '{') && !member_key())
+                                return false;
+                            break;
+                        }
+                        if (c != ((stack.back() == '{') ? '}' : ']'))
+                            return fail(ParseErrorCode::UnexpectedToken);
+                        ++p;
+                        stack.pop_back();
+                    }
+                }
+            }
+
+            // a scalar, an empty container or the beginning of a non-empty one
+            bool value()
+            {
+                skip_spaces();
+                if (p == end)
+                    return fail(ParseErrorCode::UnexpectedEnd);
+
+                switch (*p)
+                {
+                case '{':
+                    ++p;
+                    skip_spaces();
+                    if ((p != end) && (*p == '}'))
+                    {
+                        ++p;
+                        return true;
+                    }
+                    stack.push_back('{');
+                    return member_key();
+                case '[':
+                    ++p;
+                    skip_spaces();
+                    if ((p != end) && (*p == ']'))
+                    {
+                        ++p;
+                        return true;
+                    }
+                    stack.push_back('[');
+                    return true;
+                case '"':
+                    ++p;
+                    return string();
+                case 't':
+                    return literal("true", 4);
+                case 'f':
+                    return literal("false", 5);
+                case 'n':
+                    return literal("null", 4);
+                default:
+                    if ((*p == '-') || is_digit(*p))
+                        return number();
+                    return fail(ParseErrorCode::InvalidSymbol);
+                }
+            }
+
+            bool member_key()
+            {
+                skip_spaces();
+                if (p == end)
+                    return fail(ParseErrorCode::UnexpectedEnd);
+                if (*p != '"')
+                    return fail(ParseErrorCode::UnexpectedToken);
+                ++p;
+                if (!string())
+                    return false;
+
+                skip_spaces();
+                if (p == end)
+                    return fail(ParseErrorCode::UnexpectedEnd);
+                if (*p != ':')
+                    return fail(ParseErrorCode::UnexpectedToken);
+                ++p;
+                return true;
+            }
+
+            bool literal(const char * str, std::size_t size)
+            {
+                if ((static_cast<std::size_t>(end - p) < size) || !std::equal(str, str + size, p))
+                    return fail(ParseErrorCode::InvalidConstant);
+                p += size;
+                return true;
+            }
+
+            bool number()
+            {
+                auto start = p;
+                if (*p == '-')
+                    ++p;
+
+                if ((p == end) || !is_digit(*p))
+                    return fail(ParseErrorCode::InvalidNumber, start);
+                if (*p == '0')
+                {
+                    ++p;
+                }
+                else
+                {
+                    while ((p != end) && is_digit(*p))
+                        ++p;
+                }
+
+                if ((p != end) && (*p == '.'))
+                {
+                    ++p;
+                    if ((p == end) || !is_digit(*p))
+                        return fail(ParseErrorCode::InvalidNumber, start);
+                    while ((p != end) && is_digit(*p))
+                        ++p;
+                }
+
+                if ((p != end) && ((*p == 'e') || (*p == 'E')))
+                {
+                    ++p;
+                    if ((p != end) && ((*p == '+') || (*p == '-')))
+                        ++p;
+                    if ((p == end) || !is_digit(*p))
+                        return fail(ParseErrorCode::InvalidNumber, start);
+                    while ((p != end) && is_digit(*p))
+                        ++p;
+                }
+
+                // leading zeros, "01"
+                if ((p != end) && is_digit(*p))
+                    return fail(ParseErrorCode::InvalidNumber, start);
+                return true;
+            }
+
+            // the opening quote is consumed
+            bool string()
+            {
+                for (;;)
+                {
+                    p = skip_plain(p, end);
+                    if (p == end)
+                        return fail(ParseErrorCode::UnexpectedEnd);
+
+                    auto c = static_cast<unsigned char>(*p);
+                    if (c == '"')
+                    {
+                        ++p;
+                        return true;
+                    }
+                    else if (c == '\\')
+                    {
+                        if (!escape())
+                            return false;
+                    }
+                    else if (c < 0x20)
+                    {
+                        return fail(ParseErrorCode::InvalidSymbol);
+                    }
+                    else
+                    {
+                        auto size = utf8_sequence(p, end);
+                        if (!size)
+                            return fail(ParseErrorCode::InvalidUtf8);
+                        p += size;
+                    }
+                }
+            }
+
+            bool escape()
+            {
+                auto start = p++;
+                if (p == end)
+                    return fail(ParseErrorCode::UnexpectedEnd);
+
+                switch (*p)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                case 'b':
+                case 'f':
+                case 'n':
+                case 'r':
+                case 't':
+                    ++p;
+                    return true;
+                case 'u':
+                {
+                    ++p;
+                    unsigned code;
+                    if (!utf16_unit(start, code))
+                        return false;
+                    if ((code >= 0xDC00) && (code <= 0xDFFF))
+                        return fail(ParseErrorCode::InvalidEscape, start);
+                    if ((code >= 0xD800) && (code <= 0xDBFF))
+                    {
+                        // a surrogate pair, as the parser decodes it
+                        if ((end - p < 2) || (p[0] != '\\') || (p[1] != 'u'))
+                            return fail(ParseErrorCode::InvalidEscape, start);
+                        p += 2;
+                        if (!utf16_unit(start, code))
+                            return false;
+                        if ((code < 0xDC00) || (code > 0xDFFF))
+                            return fail(ParseErrorCode::InvalidEscape, start);
+                    }
+                    return true;
+                }
+                default:
+                    return fail(ParseErrorCode::InvalidEscape, start);
+                }
+            }
+
+            // four hex digits of a unicode escape
+            bool utf16_unit(const char * start, unsigned & code)
+            {
+                if (end - p < 4)
+                    return fail(ParseErrorCode::UnexpectedEnd);
+
+                code = 0;
+                for (int i = 0; i != 4; ++i, ++p)
+                {
+                    char c = *p;
+                    if (is_digit(c))
+                        code = code * 16 + (c - '0');
+                    else if ((c >= 'a') && (c <= 'f'))
+                        code = code * 16 + (c - 'a' + 10);
+                    else if ((c >= 'A') && (c <= 'F'))
+                        code = code * 16 + (c - 'A' + 10);
+                    else
+                        return fail(ParseErrorCode::InvalidEscape, start);
+                }
+                return true;
+            }
+
+            const char * const  begin;
+            const char *        p;
+            const char * const  end;
+
+            // '{' or '[' per open container
+            std::string         stack;
+            ParseStatus         status;
+        };
+    }
+
+    ParseStatus validate(utf8_text const & txt)
+    {
+        Validator v(txt);
+        v.run();
+        return v.status;
+    }
+}
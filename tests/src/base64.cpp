@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    DEF_OBJECT(Blob,
+        DEF_FIELD(std::string, name)
+        DEF_FIELD(jco::binary, data)
+    )
+
+    std::string encode(std::vector<std::uint8_t> const & bytes)
+    {
+        std::string res(jco::details::base64_encoded_size(bytes.size()), ' ');
+        res.resize(jco::details::base64_encode(bytes.data(), bytes.size(), &res[0]));
+        return res;
+    }
+
+    std::vector<std::uint8_t> bytes(const char * str)
+    {
+        return std::vector<std::uint8_t>(str, str + std::strlen(str));
+    }
+
+    TEST(base64, rfc_4648_vectors)
+    {
+        EXPECT_EQ(encode(bytes("")), "");
+        EXPECT_EQ(encode(bytes("f")), "Zg==");
+        EXPECT_EQ(encode(bytes("fo")), "Zm8=");
+        EXPECT_EQ(encode(bytes("foo")), "Zm9v");
+        EXPECT_EQ(encode(bytes("foobar")), "Zm9vYmFy");
+        EXPECT_EQ(encode(bytes("Many hands make light work.")), "TWFueSBoYW5kcyBtYWtlIGxpZ2h0IHdvcmsu");
+    }
+
+    TEST(base64, round_trip)
+    {
+        std::vector<std::uint8_t> data;
+        for (std::size_t size = 0; size != 200; ++size)
+        {
+            auto text = encode(data);
+            ASSERT_EQ(text.size(), jco::details::base64_encoded_size(size));
+
+            std::vector<std::uint8_t> decoded;
+            ASSERT_TRUE(jco::details::base64_decode(text.data(), text.size(), decoded));
+            EXPECT_EQ(decoded, data);
+
+            // every byte value, including the ones mapped to '+' and '/'
+            data.push_back(static_cast<std::uint8_t>(size * 73 + 11));
+        }
+    }
+
+    TEST(base64, def_object)
+    {
+        Blob blob{ "thumbnail", {} };
+        for (int i = 0; i != 100; ++i)
+            blob.data.bytes.push_back(static_cast<std::uint8_t>(255 - i));
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, blob);
+        }
+
+        auto parsed = jco::parse<Blob>(jco::from_string(ss.str()));
+        EXPECT_EQ(parsed.name, blob.name);
+        EXPECT_EQ(parsed.data, blob.data);
+
+        // unpadded and with an escaped slash
+        auto other = jco::parse<Blob>(jco::from_string(R"({ "name" : "", "data" : "Zm8\/Zg" })"));
+        EXPECT_EQ(other.data.bytes, (std::vector<std::uint8_t>{ 'f', 'o', '?', 'f' }));
+    }
+
+    TEST(base64, errors)
+    {
+        auto status = [] (const char * txt) {
+            return jco::try_parse<Blob>(jco::from_string(txt)).status;
+        };
+
+        EXPECT_EQ(status(R"({ "data" : "Zm9vYmFyZm9vYmFyZm9v YmFy" })").code, jco::ParseErrorCode::InvalidBase64);
+        EXPECT_EQ(status(R"({ "data" : "Zm9vYmFyZm9vYmFyZm9v YmFy" })").offset, 11u);
+        EXPECT_EQ(status(R"({ "data" : "Zm9vY" })").code, jco::ParseErrorCode::InvalidBase64);
+        EXPECT_EQ(status(R"({ "data" : "Zm9v=" })").code, jco::ParseErrorCode::InvalidBase64);
+        EXPECT_EQ(status(R"({ "data" : "Zm\n9v" })").code, jco::ParseErrorCode::InvalidBase64);
+        EXPECT_EQ(status(R"({ "data" : 1 })").code, jco::ParseErrorCode::UnexpectedToken);
+        EXPECT_EQ(status(R"({ "data" : "Zm9v )").code, jco::ParseErrorCode::UnexpectedEnd);
+    }
+}
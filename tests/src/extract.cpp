@@ -0,0 +1,153 @@
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    DEF_OBJECT(Item,
+        DEF_FIELD(double, price)
+        DEF_FIELD(std::vector<std::string>, tags)
+    )
+
+    const char * document = R"({
+        "meta" : { "id" : "abc\"d", "flags" : [true, false, null], "a/b" : 1 },
+        "items" : [
+            { "price" : 1.5 },
+            { "price" : 2 },
+            { "price" : -3e+2, "tags" : ["x", "y"] }
+        ]
+    })";
+
+    TEST(extract, values)
+    {
+        jco::PathExtractor extractor({ "/items/2/price", "/meta/id", "/meta/flags/1", "/meta/a~1b", "/items/2" });
+        auto res = extractor.extract(jco::from_string(document));
+
+        ASSERT_EQ(res.size(), 5u);
+        EXPECT_EQ(res[0].as<double>(), -300);
+        EXPECT_EQ(res[0].view(), "-3e+2");
+        EXPECT_EQ(res[1].view(), "abc\\\"d");
+        EXPECT_EQ(res[1].as<std::string>(), "abc\"d");
+        EXPECT_EQ(res[2].raw, "false");
+        EXPECT_EQ(res[3].as<double>(), 1);
+
+        auto item = res[4].as<Item>();
+        EXPECT_EQ(item.price, -300);
+        EXPECT_EQ(item.tags, std::vector<std::string>({ "x", "y" }));
+    }
+
+    TEST(extract, stops_when_everything_is_found)
+    {
+        // the rest of the document isn't even valid
+        std::string truncated(document, std::strstr(document, "\"items\""));
+        EXPECT_EQ(jco::extract(jco::from_string(truncated + "]]]"), "/meta/id").view(), "abc\\\"d");
+        EXPECT_THROW(jco::extract(jco::from_string(truncated + "]]]"), "/items"), jco::ParseError);
+    }
+
+    TEST(extract, missing_paths)
+    {
+        jco::PathExtractor extractor({ "/items/5", "/meta/id/x", "/nothing", "" });
+        auto res = extractor.extract(jco::from_string(document));
+
+        EXPECT_FALSE(res[0].found());
+        EXPECT_FALSE(res[1].found());
+        EXPECT_FALSE(res[2].found());
+        EXPECT_EQ(res[3].raw, document);
+    }
+
+    TEST(extract, duplicate_keys)
+    {
+        jco::PathExtractor extractor({ "/a", "/b", "/c" });
+        auto res = extractor.extract(jco::from_string(R"({ "a" : 1, "a" : 2, "b" : 3, "c" : 4, "b" : 5 })"));
+
+        ASSERT_TRUE(res[2].found());
+        EXPECT_EQ(res[0].raw, "2");
+        EXPECT_EQ(res[1].raw, "3");
+        EXPECT_EQ(res[2].raw, "4");
+    }
+
+    TEST(extract, array_cursor)
+    {
+        jco::ArrayCursor cursor(jco::from_string(document), "/items");
+        ASSERT_TRUE(cursor.found());
+
+        std::vector<double> prices;
+        Item item;
+        while (cursor.next())
+        {
+            cursor.read(item);
+            prices.push_back(item.price);
+        }
+        EXPECT_EQ(prices, std::vector<double>({ 1.5, 2, -300 }));
+        EXPECT_EQ(item.tags, std::vector<std::string>({ "x", "y" }));
+        EXPECT_FALSE(cursor.next());
+
+        jco::ArrayCursor skipping(jco::from_string(document), "/items");
+        ASSERT_TRUE(skipping.next());
+        skipping.skip();
+        ASSERT_TRUE(skipping.next());
+        EXPECT_EQ(skipping.read<Item>().price, 2);
+
+        // the array ends before the broken tail
+        std::string tail = R"({ "meta" : { "n" : [[], {}] }, "data" : [ ], "rest" : )";
+        jco::ArrayCursor empty(jco::from_string(tail), "/data");
+        EXPECT_TRUE(empty.found());
+        EXPECT_FALSE(empty.next());
+
+        jco::ArrayCursor root(jco::from_string("[[1], [2, 3]]"), "/1");
+        EXPECT_TRUE(root.next());
+        EXPECT_EQ(root.read<int>(), 2);
+    }
+
+    TEST(extract, array_cursor_errors)
+    {
+        jco::ArrayCursor missing(jco::from_string(document), "/items/3");
+        EXPECT_FALSE(missing.found());
+        EXPECT_FALSE(missing.next());
+
+        EXPECT_FALSE(jco::ArrayCursor(jco::from_string(document), "/meta/id/x").found());
+        EXPECT_THROW(jco::ArrayCursor(jco::from_string(document), "/meta"), jco::ParseError);
+        EXPECT_FALSE(jco::ArrayCursor(jco::from_string(document), "/meta/").found());
+
+        jco::ArrayCursor broken(jco::from_string(R"({ "data" : [1 2] })"), "/data");
+        ASSERT_TRUE(broken.next());
+        EXPECT_EQ(broken.read<int>(), 1);
+        EXPECT_THROW(broken.next(), jco::ParseError);
+    }
+
+    struct Shape
+    {
+        virtual ~Shape() {}
+        virtual double side() const = 0;
+    };
+
+    struct Square : Shape
+    {
+        explicit Square(double side) : side_(side) {}
+        double side() const override { return side_; }
+        double side_;
+    };
+
+    DEF_OBJECT(SquareRepr,
+        DEF_FIELD(double, side)
+    )
+
+    TEST(extract, array_cursor_typed)
+    {
+        jco::TypedParser<Shape> parser;
+        parser.register_factory("square", [] (jco::Parser & p) {
+            return std::unique_ptr<Shape>(new Square(p.parse<SquareRepr>().side));
+        });
+
+        auto txt = R"({ "meta" : { "count" : 2 },
+                        "data" : [{ "type" : "square", "description" : { "side" : 2 } },
+                                  { "description" : { "side" : 5 }, "type" : "square" }] })";
+
+        double total = 0;
+        jco::ArrayCursor cursor(jco::from_string(txt), "/data");
+        while (cursor.next())
+            total += parser.parse_element(cursor.parser())->side();
+        EXPECT_EQ(total, 7);
+    }
+}
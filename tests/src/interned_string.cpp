@@ -0,0 +1,62 @@
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    DEF_OBJECT(Event,
+        DEF_FIELD(jco::interned_string, status)
+        DEF_FIELD(std::vector<jco::interned_string>, tags)
+    )
+
+    TEST(interned_string, shared_by_equal_strings)
+    {
+        jco::interned_string a(std::string("status"));
+        jco::interned_string b(boost::string_ref("status_code", 6));
+
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(&a.str(), &b.str());
+        EXPECT_NE(a, jco::interned_string("code"));
+        EXPECT_EQ(jco::interned_string(""), jco::interned_string());
+    }
+
+    TEST(interned_string, def_object)
+    {
+        auto txt = jco::from_string(R"([{ "status" : "ok", "tags" : ["a", "b"] },
+                                        { "status" : "ok", "tags" : ["b"] }])");
+        auto events = jco::parse<std::vector<Event>>(txt);
+
+        ASSERT_EQ(events.size(), 2u);
+        EXPECT_EQ(events[0].status, events[1].status);
+        EXPECT_EQ(events[0].status.str(), "ok");
+        EXPECT_EQ(events[0].tags[1], events[1].tags[0]);
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, events[0]);
+        }
+        EXPECT_EQ(ss.str(), R"({ "status" : "ok", "tags" : ["a", "b"] })");
+    }
+
+    TEST(interned_string, from_many_threads)
+    {
+        const std::size_t threads_num = 4, strings_num = 1000;
+
+        std::vector<std::vector<jco::interned_string>> res(threads_num);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t != threads_num; ++t)
+        {
+            threads.emplace_back([&res, t, strings_num] {
+                for (std::size_t i = 0; i != strings_num; ++i)
+                    res[t].emplace_back(std::to_string(i));
+            });
+        }
+        for (auto & t : threads)
+            t.join();
+
+        for (std::size_t t = 1; t != threads_num; ++t)
+            EXPECT_EQ(res[t], res[0]);
+    }
+}
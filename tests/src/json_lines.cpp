@@ -0,0 +1,149 @@
+#include <sstream>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    DEF_OBJECT(Event,
+        DEF_FIELD(double, id)
+        DEF_FIELD(std::string, name)
+    )
+
+    std::string make_events(std::size_t n)
+    {
+        std::ostringstream ss;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            ss << "{ \"id\" : " << i << ", \"name\" : \"event " << i << "\" }\n";
+            if (i % 7 == 0)
+                ss << "  \r\n";
+        }
+        return ss.str();
+    }
+
+    jco::JsonLinesOptions small_blocks()
+    {
+        jco::JsonLinesOptions options;
+        options.block_size = 64;
+        options.threads = 4;
+        options.max_blocks = 3;
+        return options;
+    }
+
+    TEST(json_lines, keeps_order)
+    {
+        auto text = make_events(1000);
+        std::istringstream in(text);
+
+        std::size_t expected = 0;
+        jco::read_json_lines<Event>(in, [&expected] (Event e) {
+            ASSERT_EQ(e.id, expected);
+            ASSERT_EQ(e.name, "event " + std::to_string(expected));
+            ++expected;
+        }, small_blocks());
+        EXPECT_EQ(expected, 1000u);
+    }
+
+    TEST(json_lines, lines_longer_than_block)
+    {
+        std::string long_name(1000, 'x');
+        std::string text = "{ \"id\" : 0, \"name\" : \"" + long_name + "\" }\n"
+                           "{ \"id\" : 1, \"name\" : \"\" }";
+
+        std::vector<Event> events;
+        jco::read_json_lines<Event>(jco::from_string(text), [&events] (Event e) {
+            events.push_back(std::move(e));
+        }, small_blocks());
+
+        ASSERT_EQ(events.size(), 2u);
+        EXPECT_EQ(events[0].name, long_name);
+        EXPECT_EQ(events[1].id, 1);
+    }
+
+    TEST(json_lines, error_after_preceding_lines)
+    {
+        auto text = make_events(100) + "{ \"id\" : }\n" + make_events(100);
+        std::istringstream in(text);
+
+        std::size_t delivered = 0;
+        EXPECT_THROW(jco::read_json_lines<Event>(in, [&delivered] (Event) { ++delivered; }, small_blocks()),
+                     jco::ParseError);
+        EXPECT_EQ(delivered, 100u);
+    }
+
+    TEST(json_lines, writer_from_many_threads)
+    {
+        const std::size_t threads_num = 4, per_thread = 2000;
+
+        std::ostringstream out;
+        {
+            jco::JsonLinesWriterOptions options;
+            options.buffer_size = 1024;
+
+            jco::JsonLinesWriter writer(out, options);
+
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t != threads_num; ++t)
+            {
+                threads.emplace_back([&writer, t] {
+                    for (std::size_t i = 0; i != per_thread; ++i)
+                        writer.append(Event{ double(t * per_thread + i), "thread " + std::to_string(t) });
+                });
+            }
+            for (auto & t : threads)
+                t.join();
+
+            writer.flush();
+            auto text = out.str();
+            EXPECT_EQ(std::size_t(std::count(text.begin(), text.end(), '\n')), threads_num * per_thread);
+        }
+
+        // per thread order is kept
+        std::vector<double> last(threads_num, -1);
+        jco::read_json_lines<Event>(jco::from_string(out.str()), [&last] (Event e) {
+            auto t = std::size_t(e.id) / per_thread;
+            EXPECT_EQ(e.name, "thread " + std::to_string(t));
+            EXPECT_GT(e.id, last[t]);
+            last[t] = e.id;
+        });
+        for (std::size_t t = 0; t != threads_num; ++t)
+            EXPECT_EQ(last[t], double((t + 1) * per_thread - 1));
+    }
+
+    TEST(json_lines, writer_with_short_lived_threads)
+    {
+        const std::size_t rounds = 50, threads_num = 4, per_thread = 10;
+
+        std::ostringstream out;
+        {
+            jco::JsonLinesWriter writer(out);
+            for (std::size_t r = 0; r != rounds; ++r)
+            {
+                // buffers of exited threads are taken over by the next ones
+                std::vector<std::thread> threads;
+                for (std::size_t t = 0; t != threads_num; ++t)
+                {
+                    threads.emplace_back([&writer, r, t] {
+                        for (std::size_t i = 0; i != per_thread; ++i)
+                            writer.append(Event{ double((r * threads_num + t) * per_thread + i), "event" });
+                    });
+                }
+                for (auto & t : threads)
+                    t.join();
+            }
+
+            // a writer the threads never used
+            jco::JsonLinesWriter other(out);
+        }
+
+        std::vector<bool> seen(rounds * threads_num * per_thread);
+        jco::read_json_lines<Event>(jco::from_string(out.str()), [&seen] (Event e) {
+            ASSERT_LT(std::size_t(e.id), seen.size());
+            EXPECT_FALSE(seen[std::size_t(e.id)]);
+            seen[std::size_t(e.id)] = true;
+        });
+        EXPECT_EQ(std::size_t(std::count(seen.begin(), seen.end(), true)), seen.size());
+    }
+}
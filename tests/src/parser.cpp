@@ -0,0 +1,518 @@
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    DEF_OBJECT(Record,
+        DEF_FIELD(std::string, name)
+        DEF_FIELD(double, x)
+        DEF_FIELD(double, y, "Y")
+    )
+
+    TEST(parser, keys_in_any_order)
+    {
+        auto in_order = jco::parse<Record>(jco::from_string(R"({ "name" : "a", "x" : 1, "Y" : 2 })"));
+        auto shuffled = jco::parse<Record>(jco::from_string(R"({ "Y" : 2, "extra" : [1, {}], "x" : 1, "name" : "a" })"));
+
+        EXPECT_EQ(in_order.name, "a");
+        EXPECT_EQ(in_order.x, 1);
+        EXPECT_EQ(in_order.y, 2);
+
+        EXPECT_EQ(shuffled.name, in_order.name);
+        EXPECT_EQ(shuffled.x, in_order.x);
+        EXPECT_EQ(shuffled.y, in_order.y);
+    }
+
+    TEST(parser, require_all_fields)
+    {
+        auto txt = jco::from_string(R"({ "Y" : 2, "name" : "a" })");
+
+        jco::ParseOptions options;
+        options.require_all_fields = true;
+
+        EXPECT_NO_THROW(jco::parse<Record>(txt));
+        try
+        {
+            jco::parse<Record>(txt, options);
+            FAIL();
+        }
+        catch (jco::MissingFieldError const & e)
+        {
+            EXPECT_EQ(e.field, "x");
+        }
+
+        EXPECT_NO_THROW(jco::parse<Record>(jco::from_string(R"({ "x" : 1, "Y" : 2, "name" : "a" })"), options));
+    }
+
+    DEF_OBJECT(Batch,
+        DEF_FIELD(std::string, id)
+        DEF_FIELD(std::vector<Record>, records)
+        DEF_FIELD(std::vector<double>, values)
+    )
+
+    TEST(parser, parse_into_keeps_capacity)
+    {
+        Batch batch;
+        jco::parse_into(jco::from_string(R"({ "id" : "a rather long identifier, not a short one",
+                                              "records" : [{ "name" : "first record name, long enough", "x" : 1, "Y" : 2 },
+                                                           { "name" : "second", "x" : 3, "Y" : 4 }],
+                                              "values" : [1, 2, 3, 4, 5] })"), batch);
+
+        auto id_data = batch.id.data();
+        auto records_data = batch.records.data();
+        auto name_data = batch.records[0].name.data();
+        auto values_data = batch.values.data();
+
+        jco::parse_into(jco::from_string(R"({ "id" : "short", "records" : [{ "name" : "b", "x" : 5 }], "values" : [6] })"), batch);
+
+        EXPECT_EQ(batch.id, "short");
+        ASSERT_EQ(batch.records.size(), 1u);
+        EXPECT_EQ(batch.records[0].name, "b");
+        EXPECT_EQ(batch.records[0].x, 5);
+        // missing in the second document
+        EXPECT_EQ(batch.records[0].y, 0);
+        EXPECT_EQ(batch.values, std::vector<double>{ 6 });
+
+        EXPECT_EQ(batch.id.data(), id_data);
+        EXPECT_EQ(batch.records.data(), records_data);
+        EXPECT_EQ(batch.records[0].name.data(), name_data);
+        EXPECT_EQ(batch.values.data(), values_data);
+    }
+
+    TEST(parser, errors_without_exceptions)
+    {
+        auto ok = jco::try_parse<Record>(jco::from_string(R"({ "name" : "a", "x" : 1, "Y" : 2 })"));
+        ASSERT_TRUE(bool(ok));
+        EXPECT_EQ(ok->name, "a");
+
+        auto status = [] (const char * txt) {
+            return jco::try_parse<Batch>(jco::from_string(txt)).status;
+        };
+
+        EXPECT_EQ(status(R"({ "values" : [1, 2 3] })").code, jco::ParseErrorCode::UnexpectedToken);
+        EXPECT_EQ(status(R"({ "values" : [1, 2 3] })").offset, 19u);
+        EXPECT_EQ(status(R"({ "values" : [1, 2.e] })").code, jco::ParseErrorCode::InvalidNumber);
+        EXPECT_EQ(status(R"({ "values" : [1, 2.e] })").offset, 17u);
+        EXPECT_EQ(status(R"({ "extra" : [{ "a" : nul }] })").code, jco::ParseErrorCode::InvalidConstant);
+        EXPECT_EQ(status(R"({ "id" : "\q" })").code, jco::ParseErrorCode::InvalidEscape);
+        EXPECT_EQ(status(R"({ "records" : [{ "x" : 1 )").code, jco::ParseErrorCode::UnexpectedEnd);
+        EXPECT_EQ(status(R"({ "values" : [@] })").code, jco::ParseErrorCode::InvalidSymbol);
+        EXPECT_EQ(status(R"({} {})").code, jco::ParseErrorCode::TrailingData);
+        EXPECT_EQ(status(R"({} {})").offset, 3u);
+
+        jco::ParseOptions options;
+        options.require_all_fields = true;
+        auto missing = jco::try_parse<Record>(jco::from_string(R"({ "name" : "a", "Y" : 2 })"), options);
+        EXPECT_EQ(missing.status.code, jco::ParseErrorCode::MissingField);
+        EXPECT_EQ(missing.status.field, "x");
+    }
+
+    TEST(parser, error_offset_in_exception)
+    {
+        try
+        {
+            jco::parse<Batch>(jco::from_string(R"({ "id" : "a", "values" : [1, x] })"));
+            FAIL();
+        }
+        catch (jco::ParseError const & e)
+        {
+            EXPECT_EQ(e.code, jco::ParseErrorCode::InvalidSymbol);
+            EXPECT_EQ(e.offset, 29u);
+        }
+    }
+
+    DEF_ENUM(Status,
+        DEF_VALUE(Active, "active")
+        DEF_VALUE(Blocked, "blocked")
+        DEF_VALUE(Unknown)
+    )
+
+    DEF_OBJECT(Account,
+        DEF_FIELD(Status, status)
+        DEF_FIELD(std::vector<Status>, history)
+    )
+
+    TEST(parser, enums)
+    {
+        auto account = jco::parse<Account>(jco::from_string(R"({ "status" : "blocked", "history" : ["active", "Unknown"] })"));
+        EXPECT_EQ(account.status, Status::Blocked);
+        EXPECT_EQ(account.history, (std::vector<Status>{ Status::Active, Status::Unknown }));
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, account);
+        }
+        EXPECT_EQ(ss.str(), R"({ "status" : "blocked", "history" : ["active", "Unknown"] })");
+
+        // values without a spelling, e.g. cast from integers
+        auto write_status = [] (int status) {
+            std::ostringstream ss;
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, Account{ static_cast<Status>(status), {} });
+        };
+        EXPECT_NO_THROW(write_status(2));
+        EXPECT_THROW(write_status(3), jco::SerializationError);
+        EXPECT_THROW(write_status(-1), jco::SerializationError);
+
+        auto bad = jco::try_parse<Account>(jco::from_string(R"({ "status" : "Active" })"));
+        EXPECT_EQ(bad.status.code, jco::ParseErrorCode::UnknownEnumValue);
+        EXPECT_EQ(bad.status.offset, 13u);
+    }
+
+    // commas in types can't go through macro arguments
+    typedef std::map<std::string, double>                           SortedMap;
+    typedef std::unordered_map<std::string, std::vector<double>>    HashedMap;
+
+    DEF_OBJECT(Dictionaries,
+        DEF_FIELD(SortedMap, sorted)
+        DEF_FIELD(HashedMap, hashed)
+        DEF_FIELD(jco::flat_map<Record>, flat)
+    )
+
+    TEST(parser, maps)
+    {
+        auto txt = jco::from_string(R"({ "sorted" : { "b" : 2, "a" : 1, "b" : 3 },
+                                         "hashed" : { "x" : [1, 2], "y" : [] },
+                                         "flat" : { "k2" : { "name" : "second" }, "k1" : { "name" : "first" }, "k\u0033" : {} } })");
+        auto dicts = jco::parse<Dictionaries>(txt);
+
+        EXPECT_EQ(dicts.sorted, (SortedMap{ { "a", 1 }, { "b", 3 } }));
+        EXPECT_EQ(dicts.hashed.size(), 2u);
+        EXPECT_EQ(dicts.hashed["x"], (std::vector<double>{ 1, 2 }));
+
+        ASSERT_EQ(dicts.flat.size(), 3u);
+        EXPECT_EQ(dicts.flat.begin()->first, "k1");
+        EXPECT_EQ(dicts.flat.find("k2")->second.name, "second");
+        EXPECT_EQ(dicts.flat.count("k3"), 1u);
+        EXPECT_EQ(dicts.flat.count("k4"), 0u);
+
+        dicts.hashed.clear();
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, dicts);
+        }
+        EXPECT_EQ(ss.str(), R"({ "sorted" : { "a" : 1, "b" : 3 }, "hashed" : {  }, "flat" : { )"
+                            R"("k1" : { "name" : "first", "x" : 0, "Y" : 0 }, )"
+                            R"("k2" : { "name" : "second", "x" : 0, "Y" : 0 }, )"
+                            R"("k3" : { "name" : "", "x" : 0, "Y" : 0 } } })");
+    }
+
+    TEST(parser, flat_map_reuses_pairs)
+    {
+        jco::flat_map<std::string> map;
+        jco::parse_into(jco::from_string(R"({ "a rather long key, not a short one" : "v", "b" : "w" })"), map);
+        auto key_data = map.begin()->first.data();
+
+        jco::parse_into(jco::from_string(R"({ "short" : "x" })"), map);
+        ASSERT_EQ(map.size(), 1u);
+        EXPECT_EQ(map.begin()->first, "short");
+        EXPECT_EQ(map.begin()->first.data(), key_data);
+    }
+
+    TEST(parser, deep_unknown_values)
+    {
+        const std::size_t depth = 100000;
+        std::string nested;
+        for (std::size_t i = 0; i != depth; ++i)
+            nested += (i % 2) ? "[" : "{ \"k\" : ";
+        nested += "null";
+        for (std::size_t i = depth; i != 0; --i)
+            nested += (i % 2) ? " }" : "]";
+
+        auto txt = R"({ "name" : "a", "unknown" : )" + nested + R"(, "x" : 1 })";
+
+        auto too_deep = jco::try_parse<Record>(jco::from_string(txt));
+        EXPECT_EQ(too_deep.status.code, jco::ParseErrorCode::TooDeep);
+
+        jco::ParseOptions options;
+        options.max_depth = depth + 1;
+        auto parsed = jco::try_parse<Record>(jco::from_string(txt), options);
+        ASSERT_TRUE(bool(parsed));
+        EXPECT_EQ(parsed->x, 1);
+
+        // the record itself is one level
+        options.max_depth = depth;
+        EXPECT_EQ(jco::try_parse<Record>(jco::from_string(txt), options).status.code, jco::ParseErrorCode::TooDeep);
+    }
+
+    typedef std::array<float, 3> Point;
+
+    DEF_OBJECT(Samples,
+        DEF_FIELD(std::vector<float>, values)
+        DEF_FIELD(std::vector<int>, counts)
+        DEF_FIELD(std::vector<std::uint64_t>, ids)
+        DEF_FIELD(Point, origin)
+    )
+
+    TEST(parser, numeric_arrays)
+    {
+        auto txt = R"({ "values" : [0.5, -1.25e2,3], "counts" : [ 1 , -2, 2147483647 ],
+                        "ids" : [18446744073709551615], "origin" : [1, 2, 3] })";
+        auto samples = jco::parse<Samples>(jco::from_string(txt));
+
+        EXPECT_EQ(samples.values, (std::vector<float>{ 0.5f, -125.f, 3.f }));
+        EXPECT_EQ(samples.counts, (std::vector<int>{ 1, -2, 2147483647 }));
+        EXPECT_EQ(samples.ids, (std::vector<std::uint64_t>{ 18446744073709551615ull }));
+        EXPECT_EQ(samples.origin, (Point{ { 1.f, 2.f, 3.f } }));
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, samples);
+        }
+        EXPECT_EQ(ss.str(), R"({ "values" : [0.5, -125, 3], "counts" : [1, -2, 2147483647], )"
+                            R"("ids" : [18446744073709551615], "origin" : [1, 2, 3] })");
+
+        auto empty = jco::parse<std::vector<int>>(jco::from_string("[ ]"));
+        EXPECT_TRUE(empty.empty());
+    }
+
+    TEST(parser, numeric_array_errors)
+    {
+        auto code = [] (const char * txt) {
+            return jco::try_parse<Samples>(jco::from_string(txt)).status.code;
+        };
+
+        EXPECT_EQ(code(R"({ "counts" : [2147483648] })"), jco::ParseErrorCode::NumberOutOfRange);
+        EXPECT_EQ(code(R"({ "ids" : [-1] })"), jco::ParseErrorCode::NumberOutOfRange);
+        EXPECT_EQ(code(R"({ "ids" : [18446744073709551616] })"), jco::ParseErrorCode::NumberOutOfRange);
+        EXPECT_EQ(code(R"({ "counts" : [1.5] })"), jco::ParseErrorCode::InvalidNumber);
+        EXPECT_EQ(code(R"({ "counts" : [1, ] })"), jco::ParseErrorCode::UnexpectedToken);
+        EXPECT_EQ(code(R"({ "counts" : [1 2] })"), jco::ParseErrorCode::UnexpectedToken);
+        EXPECT_EQ(code(R"({ "origin" : [1, 2] })"), jco::ParseErrorCode::UnexpectedToken);
+        EXPECT_EQ(code(R"({ "origin" : [1, 2, 3, 4] })"), jco::ParseErrorCode::UnexpectedToken);
+
+        auto minimum = jco::parse<std::vector<std::int64_t>>(jco::from_string("[-9223372036854775808]"));
+        EXPECT_EQ(minimum.front(), std::numeric_limits<std::int64_t>::min());
+    }
+
+    TEST(parser, numeric_array_reuses_capacity)
+    {
+        std::vector<double> values;
+        jco::parse_into(jco::from_string("[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20]"), values);
+        EXPECT_EQ(values.size(), 20u);
+        EXPECT_EQ(values.capacity(), 20u);
+
+        auto data = values.data();
+        jco::parse_into(jco::from_string("[3, 2, 1]"), values);
+        EXPECT_EQ(values, (std::vector<double>{ 3, 2, 1 }));
+        EXPECT_EQ(values.data(), data);
+    }
+
+    TEST(parser, numeric_array_reserve_is_bounded)
+    {
+        // 1000 commas can't hold more than 500 elements
+        std::string txt = "[1" + std::string(1000, ',') + "]";
+
+        std::vector<double> values;
+        auto status = jco::try_parse_into(jco::from_string(txt), values);
+        EXPECT_EQ(status.code, jco::ParseErrorCode::UnexpectedToken);
+        EXPECT_LE(values.capacity(), 501u);
+    }
+
+    DEF_TABLE_OBJECT(TableLeaf,
+        DEF_FIELD(std::string, name)
+        DEF_FIELD(std::int32_t, count)
+        DEF_FIELD(float, ratio)
+    )
+
+    DEF_TABLE_OBJECT(TableRecord,
+        DEF_FIELD(std::uint64_t, id)
+        DEF_FIELD(double, x, "X")
+        DEF_FIELD(TableLeaf, leaf)
+        DEF_FIELD(std::vector<TableLeaf>, leaves)
+        DEF_FIELD(Status, status)
+    )
+
+    DEF_HOT_OBJECT(HotRecord,
+        DEF_FIELD(TableRecord, record)
+        DEF_FIELD(std::vector<std::int64_t>, ids)
+    )
+
+    TEST(parser, table_decoding)
+    {
+        auto txt = R"({ "ids" : [1, -2], "record" : { "leaves" : [{ "ratio" : 0.5, "name" : "a" }, { "count" : 3 }],
+                        "status" : "blocked", "unknown" : {}, "X" : 1.5, "id" : 18446744073709551615,
+                        "leaf" : { "name" : "b", "count" : -7, "ratio" : 2 } } })";
+        auto hot = jco::parse<HotRecord>(jco::from_string(txt));
+
+        EXPECT_EQ(hot.ids, (std::vector<std::int64_t>{ 1, -2 }));
+        auto const & record = hot.record;
+        EXPECT_EQ(record.id, 18446744073709551615ull);
+        EXPECT_EQ(record.x, 1.5);
+        EXPECT_EQ(record.leaf.name, "b");
+        EXPECT_EQ(record.leaf.count, -7);
+        EXPECT_EQ(record.leaf.ratio, 2.f);
+        ASSERT_EQ(record.leaves.size(), 2u);
+        EXPECT_EQ(record.leaves[0].name, "a");
+        EXPECT_EQ(record.leaves[0].count, 0);
+        EXPECT_EQ(record.leaves[0].ratio, 0.5f);
+        EXPECT_EQ(record.leaves[1].count, 3);
+        EXPECT_EQ(record.status, Status::Blocked);
+
+        // missing fields are cleared
+        jco::parse_into(jco::from_string(R"({ "id" : 5 })"), hot.record);
+        EXPECT_EQ(hot.record.id, 5u);
+        EXPECT_EQ(hot.record.x, 0);
+        EXPECT_EQ(hot.record.leaf.name, "");
+        EXPECT_TRUE(hot.record.leaves.empty());
+        EXPECT_EQ(hot.record.status, Status::Active);
+
+        jco::ParseOptions options;
+        options.require_all_fields = true;
+        auto missing = jco::try_parse<TableLeaf>(jco::from_string(R"({ "name" : "a", "ratio" : 1 })"), options);
+        EXPECT_EQ(missing.status.code, jco::ParseErrorCode::MissingField);
+        EXPECT_EQ(missing.status.field, "count");
+
+        auto bad = jco::try_parse<TableRecord>(jco::from_string(R"({ "leaf" : { "count" : 1.5 } })"));
+        EXPECT_EQ(bad.status.code, jco::ParseErrorCode::InvalidNumber);
+        EXPECT_EQ(bad.status.offset, 23u);
+    }
+
+    DEF_OBJECT(Attachment,
+        DEF_FIELD(std::string, name)
+        DEF_FIELD(jco::chunked_string, body)
+    )
+
+    TEST(parser, chunked_string)
+    {
+        std::string value = "\"";
+        for (int i = 0; i != 20; ++i)
+            value += "ab\\n\\u00e9\xC3\xA9x\\ud83d\\ude00\xE2\x82\xAC\\\"\\\\";
+        value += "\"";
+        auto expected = jco::parse<std::string>(jco::from_string(value));
+
+        for (std::size_t chunk_size : { 1, 8, 9, 10, 11, 64, 1000 })
+        {
+            std::string joined;
+            jco::chunked_string s;
+            s.chunk_size = chunk_size;
+            s.sink = [&joined, chunk_size] (boost::string_ref chunk) {
+                EXPECT_FALSE(chunk.empty());
+                EXPECT_LE(chunk.size(), std::max<std::size_t>(chunk_size, 8));
+                // chunks start with a whole UTF-8 sequence
+                EXPECT_NE(static_cast<unsigned char>(chunk[0]) & 0xC0, 0x80);
+                joined.append(chunk.data(), chunk.size());
+            };
+            jco::parse_into(jco::from_string(value), s);
+            EXPECT_EQ(joined, expected);
+            EXPECT_EQ(s.size, expected.size());
+        }
+
+        std::size_t delivered = 0;
+        Attachment a;
+        a.body.sink = [&delivered] (boost::string_ref chunk) { delivered += chunk.size(); };
+        jco::parse_into(jco::from_string(R"({ "body" : "0123456789", "name" : "log" })"), a);
+        EXPECT_EQ(a.name, "log");
+        EXPECT_EQ(a.body.size, 10u);
+        EXPECT_EQ(delivered, 10u);
+
+        jco::parse_into(jco::from_string(R"({ "name" : "empty" })"), a);
+        EXPECT_EQ(a.body.size, 0u);
+        jco::parse_into(jco::from_string(R"({ "body" : "abc" })"), a);
+        EXPECT_EQ(delivered, 13u);
+
+        auto unterminated = jco::try_parse<Attachment>(jco::from_string(R"({ "body" : "abc)"));
+        EXPECT_EQ(unterminated.status.code, jco::ParseErrorCode::UnexpectedEnd);
+        auto bad_escape = jco::try_parse<Attachment>(jco::from_string(R"({ "body" : "a\x" })"));
+        EXPECT_EQ(bad_escape.status.code, jco::ParseErrorCode::InvalidEscape);
+        EXPECT_EQ(bad_escape.status.offset, 14u);
+    }
+
+    TEST(parser, chunked_string_nested)
+    {
+        std::string inner_body(10000, 'i');
+        auto inner_txt = "\"" + inner_body + "\"";
+
+        std::string outer_body;
+        for (int i = 0; i != 100; ++i)
+            outer_body += "chunk " + std::to_string(i) + ";";
+
+        // every chunk of the outer value parses a larger value on the same thread
+        std::string joined;
+        jco::chunked_string outer;
+        outer.chunk_size = 16;
+        outer.sink = [&joined, &inner_txt, &inner_body] (boost::string_ref chunk) {
+            std::string inner_joined;
+            jco::chunked_string inner;
+            inner.chunk_size = 4096;
+            inner.sink = [&inner_joined] (boost::string_ref c) { inner_joined.append(c.data(), c.size()); };
+            jco::parse_into(jco::from_string(inner_txt), inner);
+            EXPECT_EQ(inner_joined, inner_body);
+
+            joined.append(chunk.data(), chunk.size());
+        };
+        jco::parse_into(jco::from_string("\"" + outer_body + "\""), outer);
+        EXPECT_EQ(joined, outer_body);
+    }
+
+    DEF_OBJECT(TrustedLeaf,
+        DEF_FIELD(double, x)
+        DEF_FIELD(std::string, s)
+    )
+
+    DEF_OBJECT(TrustedRecord,
+        DEF_FIELD(std::vector<double>, numbers)
+        DEF_FIELD(std::vector<TrustedLeaf>, leaves)
+        DEF_FIELD(std::string, escaped)
+        DEF_FIELD(std::int64_t, id)
+    )
+
+    TEST(parser, trusted_input)
+    {
+        jco::ParseOptions trusted;
+        trusted.trusted = true;
+
+        for (auto number : { "0", "-0", "0.1", "3.14159", "-2.5e-3", "1E+2", "123456", "1e22", "1e23", "0.000001234",
+                             "9007199254740993", "0.12345678901234567", "123456789012345678901234", "1.7976931348623157e308",
+                             "5e-324", "1e-400" })
+        {
+            auto expected = jco::parse<double>(jco::from_string(number));
+            auto x = jco::parse<double>(jco::from_string(number), trusted);
+            EXPECT_EQ(std::signbit(x), std::signbit(expected)) << number;
+            EXPECT_EQ(x, expected) << number;
+        }
+
+        TrustedRecord record;
+        record.numbers = { 1.5, -0.25, 1e-7, 123456, 2.5e+20 };
+        record.leaves = { { 2, "plain" }, { -3.5, "tab\t\"quoted\" \x01\x1F" } };
+        record.escaped = "\\\"\n";
+        record.id = -42;
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, record);
+        }
+        auto parsed = jco::parse<TrustedRecord>(jco::from_string(ss.str()), trusted);
+        EXPECT_EQ(parsed.numbers, record.numbers);
+        ASSERT_EQ(parsed.leaves.size(), 2u);
+        EXPECT_EQ(parsed.leaves[1].x, -3.5);
+        EXPECT_EQ(parsed.leaves[1].s, record.leaves[1].s);
+        EXPECT_EQ(parsed.escaped, record.escaped);
+        EXPECT_EQ(parsed.id, -42);
+
+        // other spellings still parse, unknown values are skipped by their brackets
+        auto txt = R"({
+            "unknown" : { "a" : [1, "]}\\\"", { "b" : null }], "c" : -1.5e3 },
+            "escaped" : "A😀",
+            "leaves" : [ {"s":"x\"}","x":1} ],
+            "skipped" : 12.5e-1,
+            "id" : 7
+        })";
+        auto expected = jco::parse<TrustedRecord>(jco::from_string(txt));
+        parsed = jco::parse<TrustedRecord>(jco::from_string(txt), trusted);
+        EXPECT_EQ(parsed.escaped, expected.escaped);
+        ASSERT_EQ(parsed.leaves.size(), 1u);
+        EXPECT_EQ(parsed.leaves[0].s, "x\"}");
+        EXPECT_EQ(parsed.id, 7);
+
+        // truncated input still fails
+        auto truncated = jco::try_parse<TrustedRecord>(jco::from_string(R"({ "unknown" : [{ "a" : "b)"), trusted);
+        EXPECT_EQ(truncated.status.code, jco::ParseErrorCode::UnexpectedEnd);
+    }
+}
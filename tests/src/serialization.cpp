@@ -1,7 +1,7 @@
 #include <iostream>
 #include <gtest/gtest.h>
 
-#include "jco/serialization.h"
+#include "jco/jco.h"
 
 namespace
 {
@@ -38,4 +38,111 @@ namespace
                 "}";
         EXPECT_EQ(ss.str(), expected);
     }
+
+    DEF_OBJECT(Inner,
+        DEF_FIELD(std::vector<double>, values)
+    )
+
+    DEF_OBJECT(Outer,
+        DEF_FIELD(std::string, name, "Name")
+        DEF_FIELD(double, x)
+        DEF_FIELD(Inner, inner)
+        DEF_FIELD(std::vector<Inner>, list)
+    )
+
+    TEST(serialization, def_object)
+    {
+        Outer obj{ "abc", 1.5, Inner{ { 1, 2 } }, { Inner{}, Inner{ { 3 } } } };
+
+        std::ostringstream ss;
+        {
+            out_stream out(ss, Style::SingleLine);
+            write(out, obj);
+        }
+        EXPECT_EQ(ss.str(), "{ \"Name\" : \"abc\", \"x\" : 1.5, \"inner\" : { \"values\" : [1, 2] }, "
+                            "\"list\" : [{ \"values\" : [] }, { \"values\" : [3] }] }");
+
+        auto parsed = jco::parse<Outer>(jco::from_string(ss.str()));
+        EXPECT_EQ(parsed.name, obj.name);
+        EXPECT_EQ(parsed.inner.values, obj.inner.values);
+        EXPECT_EQ(parsed.list.size(), 2u);
+    }
+
+    struct Point : ISerializable
+    {
+        explicit Point(double x)
+            : x(x)
+        {}
+
+        void serialize(out_stream & out) const override
+        {
+            object_scope os(out);
+            out << key("x") << value(x);
+            out << key("tags") << value(array);
+            array_stream(out) << "a" << x;
+        }
+
+        double x;
+    };
+
+    template<class Range>
+    std::string serialize_in_object(Range const & range, Style style)
+    {
+        std::ostringstream ss;
+        {
+            out_stream out(ss, style);
+            object_scope os(out);
+            out << key("points") << value(array);
+            out << range;
+        }
+        return ss.str();
+    }
+
+    TEST(serialization, parallel_range)
+    {
+        for (std::size_t n : { 0, 1, 1000, 1001 })
+        {
+            std::vector<std::unique_ptr<Point>> points;
+            for (std::size_t i = 0; i != n; ++i)
+                points.emplace_back(new Point(i));
+
+            for (Style style : { Style::SingleLine, Style::Pretty })
+            {
+                EXPECT_EQ(serialize_in_object(parallel(points, 4), style),
+                          serialize_in_object(points, style));
+            }
+        }
+    }
+
+    DEF_OBJECT(GeoPoint,
+        DEF_FIELD(jco::decimal<6>, lat)
+        DEF_FIELD(jco::decimal<6>, lon, "lng")
+    )
+
+    TEST(serialization, fixed_digits)
+    {
+        std::ostringstream ss;
+        {
+            out_stream out(ss, Style::SingleLine);
+            array_stream(out) << fixed(59.74521234, 6)
+                              << fixed(-0.0000004, 6)
+                              << fixed(-2.5, 2)
+                              << fixed(1.999, 2)
+                              << fixed(42.7, 0)
+                              << fixed(1e300, 2);
+        }
+        EXPECT_EQ(ss.str(), "[59.745212, 0.000000, -2.50, 2.00, 43, 1e+300]");
+
+        GeoPoint pt{ 60.08970001, -30.5598 };
+        ss.str("");
+        {
+            out_stream out(ss, Style::SingleLine);
+            write(out, pt);
+        }
+        EXPECT_EQ(ss.str(), R"({ "lat" : 60.089700, "lng" : -30.559800 })");
+
+        auto parsed = jco::parse<GeoPoint>(jco::from_string(ss.str()));
+        EXPECT_EQ(parsed.lat, 60.0897);
+        EXPECT_EQ(parsed.lon, -30.5598);
+    }
 }
@@ -0,0 +1,119 @@
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+#ifndef JCO_ENABLE_STATS
+#   error "the counters are checked only with JCO_ENABLE_STATS"
+#endif
+
+namespace
+{
+    DEF_OBJECT(Sample,
+        DEF_FIELD(std::string, name)
+        DEF_FIELD(std::string, note)
+        DEF_FIELD(std::vector<double>, values)
+    )
+
+    TEST(stats, parse_counters)
+    {
+        // "name" fits the small string buffer, "note" doesn't
+        auto txt = jco::from_string(R"({ "name" : "fifteen chars..", "extra" : { "x" : [1, 2] },)"
+                                    R"( "note" : "sixteen chars...", "values" : [1, 2, 3], "more" : "a\"b" })");
+
+        jco::ParseStats stats;
+        auto sample = jco::parse<Sample>(txt, stats);
+        ASSERT_EQ(sample.name, "fifteen chars..");
+        ASSERT_EQ(sample.note, "sixteen chars...");
+
+        EXPECT_EQ(stats.unmatched_keys, 2u);
+        EXPECT_EQ(stats.values_skipped, 2u);
+        EXPECT_EQ(stats.bytes_skipped, std::string(R"({ "x" : [1, 2] })").size() + std::string(R"("a\"b")").size());
+        // the skipped string isn't unescaped
+        EXPECT_EQ(stats.unescaped_strings, 0u);
+        // the note and the reserve of values
+        EXPECT_EQ(stats.allocations, 2u);
+        EXPECT_EQ(stats.max_depth, 3u);
+    }
+
+    TEST(stats, parse_escapes)
+    {
+        jco::ParseStats stats;
+        auto txt = jco::from_string(R"({ "name" : "a\"b", "note" : "0123456789abcd\u00e9", "values" : [] })");
+        auto sample = jco::parse<Sample>(txt, stats);
+        ASSERT_EQ(sample.note, "0123456789abcd\xc3\xa9");
+
+        EXPECT_EQ(stats.unescaped_strings, 2u);
+        // the escape of the note grows it past the small string buffer
+        EXPECT_EQ(stats.allocations, 1u);
+        EXPECT_EQ(stats.unmatched_keys, 0u);
+        EXPECT_EQ(stats.values_skipped, 0u);
+        EXPECT_EQ(stats.max_depth, 2u);
+    }
+
+    TEST(stats, serialization_counters)
+    {
+        Sample sample{ "a", "b", { 1, 2 } };
+
+        std::ostringstream ss;
+        jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+        jco::serialization::write(out, sample);
+
+        auto const & stats = out.stats();
+        EXPECT_EQ(stats.keys, 3u);
+        EXPECT_EQ(stats.values, 4u);
+        EXPECT_EQ(stats.containers, 2u);
+        EXPECT_EQ(stats.max_depth, 2u);
+    }
+
+    struct Point : jco::serialization::ISerializable
+    {
+        explicit Point(double x)
+            : x(x)
+        {}
+
+        void serialize(jco::serialization::out_stream & out) const override
+        {
+            using namespace jco::serialization;
+            object_scope os(out);
+            out << key("x") << value(x);
+            out << key("tags") << value(array);
+            array_stream(out) << "a" << x;
+        }
+
+        double x;
+    };
+
+    TEST(stats, parallel_serialization_counters)
+    {
+        using namespace jco::serialization;
+
+        std::vector<std::unique_ptr<Point>> points;
+        for (std::size_t i = 0; i != 1000; ++i)
+            points.emplace_back(new Point(i));
+
+        auto stats_of = [] (std::function<void (out_stream &)> write) {
+            std::ostringstream ss;
+            out_stream out(ss, Style::SingleLine);
+            object_scope os(out);
+            out << key("points") << value(array);
+            write(out);
+            return out.stats();
+        };
+
+        auto serial = stats_of([&points] (out_stream & out) { out << points; });
+        auto parallel = stats_of([&points] (out_stream & out) { out << jco::serialization::parallel(points, 4); });
+
+        EXPECT_EQ(serial.values, 3000u);
+        EXPECT_EQ(serial.keys, 2001u);
+        EXPECT_EQ(serial.containers, 2002u);
+        EXPECT_EQ(serial.max_depth, 4u);
+
+        EXPECT_EQ(parallel.values, serial.values);
+        EXPECT_EQ(parallel.keys, serial.keys);
+        EXPECT_EQ(parallel.containers, serial.containers);
+        EXPECT_EQ(parallel.max_depth, serial.max_depth);
+    }
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    struct Shape
+    {
+        virtual double area() const = 0;
+        virtual ~Shape() {}
+    };
+
+    DEF_OBJECT(SquareRepr,
+        DEF_FIELD(double, side)
+    )
+
+    DEF_OBJECT(RectRepr,
+        DEF_FIELD(double, w)
+        DEF_FIELD(double, h)
+    )
+
+    struct Square : Shape
+    {
+        explicit Square(double side) : side(side) {}
+        double area() const override { return side * side; }
+        double side;
+    };
+
+    struct Rect : Shape
+    {
+        Rect(double w, double h) : w(w), h(h) {}
+        double area() const override { return w * h; }
+        double w, h;
+    };
+
+    jco::TypedParser<Shape> make_parser()
+    {
+        jco::TypedParser<Shape> parser;
+        parser.register_factory("square", [] (jco::Parser & p) {
+            return std::unique_ptr<Shape>(new Square(p.parse<SquareRepr>().side));
+        });
+        parser.register_factory("rect", [] (jco::Parser & p) {
+            auto r = p.parse<RectRepr>();
+            return std::unique_ptr<Shape>(new Rect(r.w, r.h));
+        });
+        return parser;
+    }
+
+    TEST(typed_parser, any_key_order)
+    {
+        auto parser = make_parser();
+
+        auto type_first = parser.parse_single(jco::from_string(R"({ "type" : "square", "description" : { "side" : 2 } })"));
+        EXPECT_EQ(type_first->area(), 4);
+
+        auto description_first = parser.parse_single(jco::from_string(
+            R"({ "description" : { "w" : 2, "h" : 3, "extra" : [{ "type" : "square" }] }, "version" : 2, "type" : "rect" })"));
+        EXPECT_EQ(description_first->area(), 6);
+
+        double total = 0;
+        parser.parse_array(jco::from_string(R"([{ "meta" : null, "type" : "square", "description" : { "side" : 1 } },
+                                                { "description" : { "side" : 3 }, "type" : "square" }])"),
+                           [&total] (std::unique_ptr<Shape> s) { total += s->area(); });
+        EXPECT_EQ(total, 10);
+    }
+
+    TEST(typed_parser, envelope_errors)
+    {
+        auto parser = make_parser();
+
+        EXPECT_THROW(parser.parse_single(jco::from_string(R"({ "description" : { "side" : 2 } })")), jco::MissingFieldError);
+        EXPECT_THROW(parser.parse_single(jco::from_string(R"({ "type" : "square" })")), jco::MissingFieldError);
+        EXPECT_THROW(parser.parse_single(jco::from_string(R"({ "type" : "circle", "description" : {} })")), std::logic_error);
+        EXPECT_THROW(parser.parse_single(jco::from_string(R"({ "type" : "square", "type" : "rect", "description" : {} })")),
+                     jco::ParseError);
+        EXPECT_THROW(parser.parse_single(jco::from_string(R"({ "description" : { "side" : [ }, "type" : "square" })")),
+                     jco::ParseError);
+
+        // elements without a comma
+        try
+        {
+            parser.parse_array(jco::from_string(R"([{ "type" : "square", "description" : { "side" : 1 } } {}])"),
+                               [] (std::unique_ptr<Shape>) {});
+            FAIL();
+        }
+        catch (jco::ParseError const & e)
+        {
+            EXPECT_EQ(e.code, jco::ParseErrorCode::UnexpectedToken);
+            EXPECT_EQ(e.offset, 55u);
+        }
+
+        try
+        {
+            parser.parse_array(jco::from_string(R"([{ "type" : "square", "description" : { "side" : 1 } } )"),
+                               [] (std::unique_ptr<Shape>) {});
+            FAIL();
+        }
+        catch (jco::ParseError const & e)
+        {
+            EXPECT_EQ(e.code, jco::ParseErrorCode::UnexpectedEnd);
+        }
+    }
+
+    TEST(typed_parser, pooled_factories)
+    {
+        typedef jco::pooled_ptr<Shape> ShapePtr;
+
+        auto parser = make_parser();
+        parser.register_pooled_factory("square", [] (jco::Parser & p, jco::ParseContext & ctx) {
+            return ctx.make<Square>(p.parse<SquareRepr>().side);
+        });
+
+        jco::ParseContext ctx;
+        std::vector<ShapePtr> shapes;
+        parser.parse_array(jco::from_string(R"([{ "type" : "square", "description" : { "side" : 1 } },
+                                                { "type" : "rect", "description" : { "w" : 2, "h" : 3 } },
+                                                { "type" : "square", "description" : { "side" : 2 } }])"),
+                           ctx, [&shapes] (ShapePtr s) { shapes.push_back(std::move(s)); });
+
+        ASSERT_EQ(shapes.size(), 3u);
+        EXPECT_EQ(shapes[0]->area() + shapes[1]->area() + shapes[2]->area(), 11);
+        // rects have no pooled factory and are allocated as usual
+        EXPECT_EQ(ctx.used(), 2u);
+        EXPECT_EQ(reinterpret_cast<char *>(shapes[2].get()) - reinterpret_cast<char *>(shapes[0].get()),
+                  static_cast<std::ptrdiff_t>(sizeof(Square)));
+
+        // a released slot is taken by the next object
+        auto first = shapes[0].get();
+        shapes[0].reset();
+        EXPECT_EQ(ctx.used(), 1u);
+        auto square = parser.parse_single(jco::from_string(R"({ "description" : { "side" : 3 }, "type" : "square" })"), ctx);
+        EXPECT_EQ(square.get(), first);
+        EXPECT_EQ(square->area(), 9);
+
+        EXPECT_THROW(parser.parse_single(jco::from_string(R"({ "type" : "square", "description" : { "side" : "1" } })"), ctx),
+                     jco::ParseError);
+        EXPECT_EQ(ctx.used(), 2u);
+
+        square.reset();
+        shapes.clear();
+        EXPECT_EQ(ctx.used(), 0u);
+    }
+
+    TEST(typed_parser, pooled_only_factory)
+    {
+        jco::TypedParser<Shape> parser;
+        parser.register_pooled_factory("square", [] (jco::Parser & p, jco::ParseContext & ctx) {
+            return ctx.make<Square>(p.parse<SquareRepr>().side);
+        });
+
+        auto txt = jco::from_string(R"({ "type" : "square", "description" : { "side" : 2 } })");
+        EXPECT_THROW(parser.parse_single(txt), std::logic_error);
+
+        jco::ParseContext ctx;
+        EXPECT_EQ(parser.parse_single(txt, ctx)->area(), 4);
+        EXPECT_EQ(ctx.used(), 0u);
+    }
+
+    TEST(typed_parser, pooled_objects_outliving_context)
+    {
+        EXPECT_DEATH({
+            jco::pooled_ptr<Shape> square;
+            jco::ParseContext ctx;
+            square = ctx.make<Square>(1);
+        }, "ParseContext destroyed with 1 pooled objects alive");
+    }
+
+    TEST(typed_parser, lazy_forwarding)
+    {
+        std::size_t parsed = 0;
+        jco::TypedParser<Shape> parser;
+        parser.register_factory("square", [&parsed] (jco::Parser & p) {
+            ++parsed;
+            return std::unique_ptr<Shape>(new Square(p.parse<SquareRepr>().side));
+        });
+
+        auto txt = R"([{ "type" : "square", "description" :{"side":2} },
+                       { "description" : { "side" : 3, "color" : [1, 2] }, "type" : "square" },
+                       { "type" : "square", "description" : { "side" : "x" } }])";
+
+        std::vector<jco::lazy_object<Shape>> shapes;
+        parser.parse_lazy_array(jco::from_string(txt), [&shapes] (jco::lazy_object<Shape> s) {
+            shapes.push_back(std::move(s));
+        });
+
+        ASSERT_EQ(shapes.size(), 3u);
+        EXPECT_EQ(shapes[0].type(), "square");
+        EXPECT_EQ(shapes[0].description(), R"({"side":2})");
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, shapes);
+        }
+        EXPECT_EQ(ss.str(), R"([{ "type" : "square", "description" : {"side":2} }, )"
+                            R"({ "type" : "square", "description" : { "side" : 3, "color" : [1, 2] } }, )"
+                            R"({ "type" : "square", "description" : { "side" : "x" } }])");
+        EXPECT_EQ(parsed, 0u);
+
+        EXPECT_EQ(shapes[1]->area(), 9);
+        EXPECT_EQ(shapes[1]->area(), 9);
+        EXPECT_TRUE(shapes[1].parsed());
+        EXPECT_FALSE(shapes[0].parsed());
+        EXPECT_EQ(parsed, 1u);
+
+        EXPECT_THROW(shapes[2].get(), jco::ParseError);
+
+        auto single = parser.parse_lazy_single(jco::from_string(R"({ "type" : "square", "description" : { "side" : 1 } })"));
+        std::ostringstream pretty;
+        {
+            jco::serialization::out_stream out(pretty, jco::serialization::Style::Pretty);
+            jco::serialization::write(out, single);
+        }
+        EXPECT_EQ(pretty.str(), "{\n  \"type\" : \"square\",\n  \"description\" : { \"side\" : 1 }\n}");
+        EXPECT_EQ(single.release()->area(), 1);
+
+        EXPECT_THROW(parser.parse_lazy_single(jco::from_string(R"({ "type" : "square", "description" : { "side" : 1 )")),
+                     jco::ParseError);
+    }
+
+    DEF_TYPE_NAME(SquareRepr, "square")
+    DEF_TYPE_NAME(RectRepr, "rect")
+
+    typedef boost::variant<SquareRepr, RectRepr> ShapeRepr;
+
+    double area(ShapeRepr const & s)
+    {
+        if (auto square = boost::get<SquareRepr>(&s))
+            return square->side * square->side;
+        auto const & rect = boost::get<RectRepr>(s);
+        return rect.w * rect.h;
+    }
+
+    TEST(typed_parser, variant_array)
+    {
+        auto txt = R"([{ "type" : "rect", "description" : { "w" : 2, "h" : 3 } },
+                       { "description" : { "side" : 3 }, "meta" : {}, "type" : "square" }])";
+        auto shapes = jco::parse<std::vector<ShapeRepr>>(jco::from_string(txt));
+
+        ASSERT_EQ(shapes.size(), 2u);
+        EXPECT_EQ(shapes[0].which(), 1);
+        EXPECT_EQ(area(shapes[0]), 6);
+        EXPECT_EQ(area(shapes[1]), 9);
+
+        std::ostringstream ss;
+        {
+            jco::serialization::out_stream out(ss, jco::serialization::Style::SingleLine);
+            jco::serialization::write(out, shapes);
+        }
+        EXPECT_EQ(ss.str(), R"([{ "type" : "rect", "description" : { "w" : 2, "h" : 3 } }, )"
+                            R"({ "type" : "square", "description" : { "side" : 3 } }])");
+
+        auto unknown = jco::try_parse<std::vector<ShapeRepr>>(jco::from_string(R"([{ "type" : "circle", "description" : {} }])"));
+        EXPECT_EQ(unknown.status.code, jco::ParseErrorCode::UnknownType);
+        EXPECT_EQ(unknown.status.offset, 12u);
+
+        auto missing = jco::try_parse<ShapeRepr>(jco::from_string(R"({ "type" : "square" })"));
+        EXPECT_EQ(missing.status.code, jco::ParseErrorCode::MissingField);
+        EXPECT_EQ(missing.status.field, "description");
+    }
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "jco/jco.h"
+
+namespace
+{
+    jco::ParseStatus validate(std::string const & txt)
+    {
+        return jco::validate(jco::from_string(txt));
+    }
+
+    TEST(validate, well_formed)
+    {
+        EXPECT_TRUE(bool(validate(R"({ "a" : [1, -0.5, 2e+10, true, false, null, {}, []], "b" : { "c" : "d" } })")));
+        EXPECT_TRUE(bool(validate("\xEF\xBB\xBF [\"\\u00e9\\ud83d\\ude00\", \"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\"] ")));
+        EXPECT_TRUE(bool(validate(std::string(10000, '[') + std::string(10000, ']'))));
+        // long enough for the vectorized path
+        EXPECT_TRUE(bool(validate("\"" + std::string(100, 'a') + "\xC3\xA9" + std::string(100, 'b') + "\"")));
+    }
+
+    TEST(validate, grammar_errors)
+    {
+        using jco::ParseErrorCode;
+
+        EXPECT_EQ(validate("[1, 2,]").code,         ParseErrorCode::InvalidSymbol);
+        EXPECT_EQ(validate("{ \"a\" : 1, }").code,  ParseErrorCode::UnexpectedToken);
+        EXPECT_EQ(validate("[01]").code,            ParseErrorCode::InvalidNumber);
+        EXPECT_EQ(validate("[-]").code,             ParseErrorCode::InvalidNumber);
+        EXPECT_EQ(validate("[1.]").code,            ParseErrorCode::InvalidNumber);
+        EXPECT_EQ(validate("[tru]").code,           ParseErrorCode::InvalidConstant);
+        EXPECT_EQ(validate("[\"\\x\"]").code,       ParseErrorCode::InvalidEscape);
+        EXPECT_EQ(validate("[\"\\udc00\"]").code,   ParseErrorCode::InvalidEscape);
+        EXPECT_EQ(validate("[\"a\tb\"]").code,      ParseErrorCode::InvalidSymbol);
+        EXPECT_EQ(validate("[1] 2").code,           ParseErrorCode::TrailingData);
+        EXPECT_EQ(validate("{ \"a\" : [1").code,    ParseErrorCode::UnexpectedEnd);
+        EXPECT_EQ(validate("").code,                ParseErrorCode::UnexpectedEnd);
+
+        EXPECT_EQ(validate("[1, 2 3]").offset, 6u);
+    }
+
+    TEST(validate, utf8_errors)
+    {
+        const char * malformed[] = {
+            "\x80",             // a lone continuation byte
+            "\xC0\xAF",         // overlong
+            "\xE0\x80\xAF",     // overlong
+            "\xED\xA0\x80",     // a surrogate
+            "\xF4\x90\x80\x80", // above U+10FFFF
+            "\xE2\x82",         // truncated
+            "\xFF"
+        };
+
+        for (auto bytes : malformed)
+        {
+            auto txt = "[\"" + std::string(20, 'x') + bytes + "\"]";
+            auto status = validate(txt);
+            EXPECT_EQ(status.code, jco::ParseErrorCode::InvalidUtf8) << txt;
+            EXPECT_EQ(status.offset, 22u);
+        }
+    }
+}